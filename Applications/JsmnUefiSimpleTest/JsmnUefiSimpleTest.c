@@ -10,14 +10,28 @@ static CHAR16 *JSON_STRING =
 	  "\"groups\": [\"users\", \"wheel\", \"audio\", \"video\"]}";
 
 static int jsoneq(const CHAR16 *json, JSMNTOK_T *tok, const CHAR16 *s) {
-	if (tok->Type == JSMN_STRING && (INT8) StrLen(s) == tok->End - tok->Start &&
-		  CompareMem(json + tok->Start, s, tok->End - tok->Start) == 0) {
+	if (tok->Type == JSMN_STRING && StrLen(s) == (UINTN)(tok->End - tok->Start) &&
+		  CompareMem(json + tok->Start, s, StrLen(s) * sizeof(CHAR16)) == 0) {
 	  return 0;
 	}
 
 	return -1;
 }
 
+/* Returns the index of the token after t[i] and everything below it */
+static int SkipValue(JSMNTOK_T *t, int i) {
+	int Left;
+
+	for (Left = 1; Left > 0; i++) {
+		Left += t[i].Size - 1;
+	}
+	return i;
+}
+
+static void PrintValue(const CHAR16 *name, JSMNTOK_T *tok) {
+	Print(L"- %s: %.*s\n", name, tok->End - tok->Start, JSON_STRING + tok->Start);
+}
+
 EFI_STATUS
 EFIAPI
 UefiMain (
@@ -29,6 +43,8 @@ UefiMain (
 	int r;
 	JSMN_PARSER p;
 	JSMNTOK_T t[128]; /* We expect no more than 128 tokens */
+	JSMN_SLOT Slots[16];
+	JSMN_KEY_INDEX Index;
 
 	JsmnInit(&p);
 	r = JsmnParser(&p, JSON_STRING, StrLen(JSON_STRING), t, sizeof(t)/sizeof(t[0]));
@@ -43,36 +59,46 @@ UefiMain (
 		return 1;
 	}
 
-	/* Loop over all keys of the root object */
-	for (i = 1; i < r; i++) {
-		if (jsoneq(JSON_STRING, &t[i], L"user") == 0) {
-			/* We may use strndup() to fetch string value */
-			Print(L"- User: %.*s\n", t[i+1].End-t[i+1].Start,
-					JSON_STRING + t[i+1].Start);
-			i++;
-		} else if (jsoneq(JSON_STRING, &t[i], L"admin") == 0) {
-			/* We may additionally check if the value is either "true" or "false" */
-			Print(L"- Admin: %.*s\n", t[i+1].End-t[i+1].Start,
-					JSON_STRING + t[i+1].Start);
-			i++;
-		} else if (jsoneq(JSON_STRING, &t[i], L"uid") == 0) {
-			/* We may want to do strtol() here to get numeric value */
-			Print(L"- UID: %.*s\n", t[i+1].End-t[i+1].Start,
-					JSON_STRING + t[i+1].Start);
-			i++;
-		} else if (jsoneq(JSON_STRING, &t[i], L"groups") == 0) {
-			int j;
-			Print(L"- Groups:\n");
-			if (t[i+1].Type != JSMN_ARRAY) {
-				continue; /* We expect groups to be an array of strings */
-			}
-			for (j = 0; j < t[i+1].Size; j++) {
-				JSMNTOK_T *g = &t[i+j+2];
+	/* Index the keys of all objects, then look them up in O(1) */
+	Index.Slots = Slots;
+	Index.Size = JsmnKeyIndexSize(t, r);
+	if (Index.Size > sizeof(Slots)/sizeof(Slots[0]) ||
+			JsmnBuildKeyIndex(&Index, JSON_STRING, t, r) < 0) {
+		Print(L"Too many keys\n");
+		return 1;
+	}
+
+	if ((i = JsmnLookup(&Index, JSON_STRING, t, 0, L"user")) >= 0) {
+		/* We may use strndup() to fetch string value */
+		PrintValue(L"User", &t[i]);
+	}
+	if ((i = JsmnLookup(&Index, JSON_STRING, t, 0, L"admin")) >= 0) {
+		/* We may additionally check if the value is either "true" or "false" */
+		PrintValue(L"Admin", &t[i]);
+	}
+	if ((i = JsmnLookup(&Index, JSON_STRING, t, 0, L"uid")) >= 0) {
+		/* We may want to do strtol() here to get numeric value */
+		PrintValue(L"UID", &t[i]);
+	}
+	if ((i = JsmnLookup(&Index, JSON_STRING, t, 0, L"groups")) >= 0) {
+		int j;
+		Print(L"- Groups:\n");
+		/* We expect groups to be an array of strings */
+		if (t[i].Type == JSMN_ARRAY) {
+			for (j = 0; j < t[i].Size; j++) {
+				JSMNTOK_T *g = &t[i+j+1];
 				Print(L"  * %.*s\n", g->End - g->Start, JSON_STRING + g->Start);
 			}
-			i += t[i+1].Size + 1;
-		} else {
-			Print(L"Unexpected key: %.*s\n", t[i].End-t[i].Start,
+		}
+	}
+
+	/* Loop over all keys of the root object for the ones not handled above */
+	for (i = 1; i < r; i = SkipValue(t, i)) {
+		if (jsoneq(JSON_STRING, &t[i], L"user") != 0 &&
+				jsoneq(JSON_STRING, &t[i], L"admin") != 0 &&
+				jsoneq(JSON_STRING, &t[i], L"uid") != 0 &&
+				jsoneq(JSON_STRING, &t[i], L"groups") != 0) {
+			Print(L"Unexpected key: %.*s\n", t[i].End - t[i].Start,
 					JSON_STRING + t[i].Start);
 		}
 	}
@@ -28,9 +28,38 @@ enum Jsmnerr {
 	JSMN_ERROR_INVAL = -2,
 
 	// The string is not a full JSON packet, more bytes expected
-	JSMN_ERROR_PART = -3
+	JSMN_ERROR_PART = -3,
+
+	// The number does not fit the type it is read as; -5 as in jsmn.h, -4
+	// being JSMN_ERROR_FILE there
+	JSMN_ERROR_RANGE = -5
 };
 
+#ifdef JSMN_PACKED
+//
+// Packed JSON token for documents shorter than 0xFFFF characters, 8 bytes
+// instead of 16. Start and End read 0xFFFF rather than -1 while unset.
+//
+typedef struct {
+	UINT16 Start;
+	UINT16 End;
+	UINT16 Size;
+	UINT16 Type;
+} JSMNPLAINTOK_T;
+
+//
+// The same with Parent, the index of the parent token or -1.
+//
+typedef struct {
+	UINT16 Start;
+	UINT16 End;
+	UINT16 Size;
+	UINT16 Type;
+	INT32 Parent;
+} JSMNLINKTOK_T;
+
+#define JSMN_UNSET 0xFFFF
+#else
 //
 // JSON token description.
 // type		type (object, array, string etc.)
@@ -42,10 +71,42 @@ typedef struct {
 	INT32 Start;
 	INT32 End;
 	INT32 Size;
+} JSMNPLAINTOK_T;
+
+//
+// The same with Parent, the index of the parent token or -1.
+//
+typedef struct {
+	JSMNTYPE_T Type;
+	INT32 Start;
+	INT32 End;
+	INT32 Size;
+	INT32 Parent;
+} JSMNLINKTOK_T;
+
+#define JSMN_UNSET -1
+#endif
+
+//
+// The token of JsmnParser() and of every other function below but the named
+// parser variants: a linked one with JSMN_PARENT_LINKS, a plain one without.
+//
 #ifdef JSMN_PARENT_LINKS
-	int Parent;
+typedef JSMNLINKTOK_T JSMNTOK_T;
+#else
+typedef JSMNPLAINTOK_T JSMNTOK_T;
+#endif
+
+//
+// Nesting depth up to which open objects and arrays are tracked on the
+// parser's own stack. With linked tokens, deeper containers are found by
+// following the links and parsing stays linear. Without them, each comma and
+// closing bracket deeper than this scans back over the tokens, so a wide array
+// nested below this depth is quadratic again.
+//
+#ifndef JSMN_MAX_DEPTH
+#define JSMN_MAX_DEPTH 32
 #endif
-} JSMNTOK_T;
 
 //
 // JSON parser. Contains an array of token blocks available. Also stores
@@ -55,6 +116,10 @@ typedef struct {
 	UINT32 Pos; 		// offset in the JSON string
 	UINT32 Toknext; 	// next token to allocate
 	INT32 Toksuper; 	// superior token node, e.g parent object or array
+	INT32 State; 		// lexer state of a string or primitive cut by end of input
+	UINT32 Tokstart; 	// ... and its start offset
+	UINT32 Depth; 		// number of objects and arrays not closed yet
+	INT32 Stack[JSMN_MAX_DEPTH]; 	// their token indexes, innermost last
 } JSMN_PARSER;
 
 
@@ -75,6 +140,9 @@ JsmnInit (
 	a single JSON object.
 
 	This function has the responsibility to parse JSON string and fill tokens.
+	When the input ends early, JSMN_ERROR_PART is returned and a later call with
+	more of the same input carries on from where this one stopped, even inside
+	a string or primitive.
 
 	@param  parser		A pointer to a object parser containing an array of tokens.
 	@param  js			A pointer to a Null-terminated unicode :q.
@@ -83,6 +151,7 @@ JsmnInit (
 	@param  num_tokens	The maximum number of tokens that is assumed to be parsed.
 
 	@return The number of parsed tokens or a jsmn error while try to parse the input string.
+			With JSMN_PACKED, input of 0xFFFF characters or more is JSMN_ERROR_INVAL.
 
 **/
 UINT32
@@ -95,5 +164,318 @@ JsmnParser (
 	IN UINT32 NumTokens
 );
 
+/**
+	Run JSON parser over CHAR8 input, such as a configuration blob read from a
+	file or a variable, without widening it to CHAR16 first.
+
+	The tokens are the same JsmnParser() produces for the widened input, with
+	Start and End counted in bytes. Bytes of 0x80 and above are accepted inside
+	strings, so UTF-8 text passes through unchanged; elsewhere they are an error.
+
+	@param  Parser		A pointer to a object parser containing an array of tokens.
+	@param  Js			A pointer to the ASCII or UTF-8 input.
+	@param  Len			The length of input in bytes.
+	@param  Tokens		A pointer to a an array of tokens parsed from input string.
+	@param  NumTokens	The maximum number of tokens that is assumed to be parsed.
+
+	@return The number of parsed tokens or a jsmn error while try to parse the input string.
+
+**/
+UINT32
+EFIAPI
+JsmnParserAscii (
+	IN JSMN_PARSER *Parser,
+	IN CONST CHAR8 *Js,
+	IN UINTN Len,
+	OUT JSMNTOK_T *Tokens,
+	IN UINT32 NumTokens
+);
+
+/**
+	JsmnParser() and JsmnParserAscii() with the grammar and the token layout
+	fixed regardless of JSMN_STRICT and JSMN_PARENT_LINKS: strict JSON or the
+	lenient grammar with unquoted values and keys, into plain tokens or into
+	tokens linked to their parents. All of them are always built, so one image
+	can use any of them. Keep to one of them per parser.
+
+	@param  Parser		A pointer to a object parser containing an array of tokens.
+	@param  Js			A pointer to the CHAR16 input, or to the CHAR8 input of the
+						Ascii variants.
+	@param  Len			The length of input string to be parsed.
+	@param  Tokens		A pointer to a an array of tokens parsed from input string.
+	@param  NumTokens	The maximum number of tokens that is assumed to be parsed.
+
+	@return The number of parsed tokens or a jsmn error while try to parse the input string.
+
+**/
+UINT32
+EFIAPI
+JsmnParserStrict (
+	IN JSMN_PARSER *Parser,
+	IN CONST CHAR16 *Js,
+	IN UINTN Len,
+	OUT JSMNPLAINTOK_T *Tokens,
+	IN UINT32 NumTokens
+);
+
+UINT32
+EFIAPI
+JsmnParserLenient (
+	IN JSMN_PARSER *Parser,
+	IN CONST CHAR16 *Js,
+	IN UINTN Len,
+	OUT JSMNPLAINTOK_T *Tokens,
+	IN UINT32 NumTokens
+);
+
+UINT32
+EFIAPI
+JsmnParserStrictLinks (
+	IN JSMN_PARSER *Parser,
+	IN CONST CHAR16 *Js,
+	IN UINTN Len,
+	OUT JSMNLINKTOK_T *Tokens,
+	IN UINT32 NumTokens
+);
+
+UINT32
+EFIAPI
+JsmnParserLenientLinks (
+	IN JSMN_PARSER *Parser,
+	IN CONST CHAR16 *Js,
+	IN UINTN Len,
+	OUT JSMNLINKTOK_T *Tokens,
+	IN UINT32 NumTokens
+);
+
+UINT32
+EFIAPI
+JsmnParserAsciiStrict (
+	IN JSMN_PARSER *Parser,
+	IN CONST CHAR8 *Js,
+	IN UINTN Len,
+	OUT JSMNPLAINTOK_T *Tokens,
+	IN UINT32 NumTokens
+);
+
+UINT32
+EFIAPI
+JsmnParserAsciiLenient (
+	IN JSMN_PARSER *Parser,
+	IN CONST CHAR8 *Js,
+	IN UINTN Len,
+	OUT JSMNPLAINTOK_T *Tokens,
+	IN UINT32 NumTokens
+);
+
+UINT32
+EFIAPI
+JsmnParserAsciiStrictLinks (
+	IN JSMN_PARSER *Parser,
+	IN CONST CHAR8 *Js,
+	IN UINTN Len,
+	OUT JSMNLINKTOK_T *Tokens,
+	IN UINT32 NumTokens
+);
+
+UINT32
+EFIAPI
+JsmnParserAsciiLenientLinks (
+	IN JSMN_PARSER *Parser,
+	IN CONST CHAR8 *Js,
+	IN UINTN Len,
+	OUT JSMNLINKTOK_T *Tokens,
+	IN UINT32 NumTokens
+);
+
+/**
+	Run JSON parser with a pool-allocated array of tokens that grows as needed.
+
+	When the array is full its size is doubled with ReallocatePool() and
+	parsing carries on from where it stopped.
+
+	@param  Parser		A pointer to a object parser containing an array of tokens.
+	@param  Js			A pointer to a Null-terminated unicode string.
+	@param  Len			The length of input string to be parsed.
+	@param  Tokens		On input, the current pool-allocated array of tokens or NULL.
+						On output, the possibly moved array, to be freed with FreePool().
+	@param  NumTokens	On input, the number of tokens in the array. On output, its
+						new size.
+
+	@return The number of parsed tokens or a jsmn error while try to parse the input
+			string. JSMN_ERROR_NOMEM means that the pool could not be grown.
+
+**/
+INT32
+EFIAPI
+JsmnParserGrow (
+	IN JSMN_PARSER *Parser,
+	IN CONST CHAR16 *Js,
+	IN UINTN Len,
+	IN OUT JSMNTOK_T **Tokens,
+	IN OUT UINT32 *NumTokens
+);
+
+//
+// Slot of a key index: a key token and the object it belongs to. Free slots
+// have Key 0.
+//
+typedef struct {
+	INT32 Object;
+	INT32 Key;
+} JSMN_SLOT;
+
+//
+// Hash table of the keys of every object of a token array, with open
+// addressing and linear probing. Size is a power of two.
+//
+typedef struct {
+	JSMN_SLOT *Slots;
+	UINT32 Size;
+} JSMN_KEY_INDEX;
+
+/**
+	Compute the number of slots of a key index for an array of tokens.
+
+	@param  Tokens		A pointer to an array of parsed tokens.
+	@param  NumTokens	The number of parsed tokens.
+
+	@return Twice the number of keys, rounded up to a power of two.
+
+**/
+UINT32
+EFIAPI
+JsmnKeyIndexSize (
+	IN CONST JSMNTOK_T *Tokens,
+	IN UINT32 NumTokens
+);
+
+/**
+	Index the keys of every object of a parsed token array.
+
+	@param  Index		A key index whose Size comes from JsmnKeyIndexSize() and
+						whose Slots are filled in.
+	@param  Js			A pointer to the parsed unicode string.
+	@param  Tokens		A pointer to an array of parsed tokens.
+	@param  NumTokens	The number of parsed tokens.
+
+	@return The number of keys, or JSMN_ERROR_NOMEM if the slots are too few.
+
+**/
+INT32
+EFIAPI
+JsmnBuildKeyIndex (
+	IN OUT JSMN_KEY_INDEX *Index,
+	IN CONST CHAR16 *Js,
+	IN CONST JSMNTOK_T *Tokens,
+	IN UINT32 NumTokens
+);
+
+/**
+	Look a key up in an object in O(1) on average.
+
+	The key is compared with the key as it is written in Js, escapes are not
+	decoded.
+
+	@param  Index		A key index built by JsmnBuildKeyIndex().
+	@param  Js			A pointer to the parsed unicode string.
+	@param  Tokens		A pointer to the array of parsed tokens.
+	@param  Object		The index of the object token.
+	@param  Key			A pointer to a Null-terminated unicode key.
+
+	@return The index of the value of the key, of the first one if the key is
+			repeated, or -1.
+
+**/
+INT32
+EFIAPI
+JsmnLookup (
+	IN CONST JSMN_KEY_INDEX *Index,
+	IN CONST CHAR16 *Js,
+	IN CONST JSMNTOK_T *Tokens,
+	IN INT32 Object,
+	IN CONST CHAR16 *Key
+);
+
+/**
+	Read a primitive token as a signed 64-bit integer.
+
+	@param  Js			A pointer to the parsed unicode string.
+	@param  Token		A pointer to a primitive token.
+	@param  Value		On success, the value of the number.
+
+	@return 0, JSMN_ERROR_INVAL if the token is not a JSON number without
+			fraction and exponent, or JSMN_ERROR_RANGE if it does not fit.
+
+**/
+INT32
+EFIAPI
+JsmnGetInt64 (
+	IN CONST CHAR16 *Js,
+	IN CONST JSMNTOK_T *Token,
+	OUT INT64 *Value
+);
+
+/**
+	Read a primitive token as an unsigned 64-bit integer.
+
+	@param  Js			A pointer to the parsed unicode string.
+	@param  Token		A pointer to a primitive token.
+	@param  Value		On success, the value of the number.
+
+	@return 0, JSMN_ERROR_INVAL if the token is not a JSON number without
+			fraction and exponent, or JSMN_ERROR_RANGE if it does not fit or
+			is negative.
+
+**/
+INT32
+EFIAPI
+JsmnGetUint64 (
+	IN CONST CHAR16 *Js,
+	IN CONST JSMNTOK_T *Token,
+	OUT UINT64 *Value
+);
+
+
+/**
+	Count the code units a string token takes once its escapes are decoded.
+
+	@param  Js			A pointer to the parsed unicode string.
+	@param  Token		A pointer to a string or primitive token.
+
+	@return The number of code units, or JSMN_ERROR_INVAL for an object or
+			array token.
+
+**/
+INT32
+EFIAPI
+JsmnUnescapedLength (
+	IN CONST CHAR16 *Js,
+	IN CONST JSMNTOK_T *Token
+);
+
+/**
+	Decode the escapes of a string token into a buffer. A surrogate pair
+	written as two "\uXXXX" escapes is stored as the two code units. No Null
+	terminator is added.
+
+	@param  Js			A pointer to the parsed unicode string.
+	@param  Token		A pointer to a string or primitive token.
+	@param  Buffer		A pointer to the buffer to fill.
+	@param  Size		The number of CHAR16 the buffer holds.
+
+	@return The number of code units stored, JSMN_ERROR_NOMEM if they are more
+			than Size, or JSMN_ERROR_INVAL for an object or array token.
+
+**/
+INT32
+EFIAPI
+JsmnUnescape (
+	IN CONST CHAR16 *Js,
+	IN CONST JSMNTOK_T *Token,
+	OUT CHAR16 *Buffer,
+	IN UINTN Size
+);
+
 
 #endif
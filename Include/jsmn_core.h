@@ -0,0 +1,458 @@
+/*
+ * Tokenizer core of jsmn_parse() and of JsmnParser() in JsmnUefiLib, written
+ * once and included by jsmn.c and JsmnUefiLib.c for every variant they build.
+ * Each inclusion fixes the character type, the grammar and the token layout,
+ * so the loop of every variant carries no test of its own and the variants
+ * can be linked together.
+ *
+ * Set once by the including file, for all of its variants:
+ * 	JSMN_CORE_PARSER	the parser type, whose fields are named by
+ * 				JSMN_POS, JSMN_TOKNEXT, JSMN_TOKSUPER, JSMN_STATE,
+ * 				JSMN_TOKSTART, JSMN_DEPTH and JSMN_STACK
+ * 	JSMN_CORE_INT		signed type of offsets and token indexes
+ * 	JSMN_CORE_UINT		type of the number of tokens
+ * 	JSMN_CORE_SIZE		type of the input length
+ * 	JSMN_CORE_RET		return type of the parser, with its calling
+ * 				convention if any
+ * 	JSMN_PARENT		the name of the parent field of a linked token
+ * 	jsmn_tok_type(t)	type of a token
+ * 	jsmn_tok_size(t)	its number of children
+ * 	jsmn_tok_reset(t)	marks a newly allocated token unset
+ * 	jsmn_tok_fill(t, type, start, end)
+ * 				fills it, with end -1 for an object or array
+ * 	jsmn_tok_add_child(t)	counts one more child
+ * 	jsmn_tok_close(t, end, span)
+ * 				closes an object or array
+ * 	jsmn_tok_is_open(t)	whether t is an object or array not closed yet
+ * 	JSMN_CORE_MAX_LEN	if defined, the longest string or primitive a
+ * 				token holds
+ * 	JSMN_CORE_INPUT_LIMIT	if defined, the input length from which input
+ * 				is refused
+ * For each character type:
+ * 	JSMN_CORE_CHAR		the character type of the input
+ * 	JSMN_CORE_UNIT		the same as an unsigned type
+ * 	JSMN_CORE_SKIP_SPACE(map, js, len, pos)
+ * 				if defined, the first position at or after pos
+ * 				that is not whitespace, using a whitespace map of
+ * 				type JSMN_CORE_SPACE_MAP
+ * 	JSMN_CORE_SCAN_STRING(js, len, pos)
+ * 				if defined, the first quote, backslash or control
+ * 				character at or after pos
+ * 	JSMN_CORE_SCAN_CHECKED(js, len, &pos)
+ * 				if defined instead, the same, also checking the
+ * 				string body on the way; returns 0, JSMN_ERROR_PART
+ * 				or an error
+ * For each variant, undefined again at the end of this file:
+ * 	JSMN_CORE(name)		the name of helper name in this variant
+ * 	JSMN_CORE_PARSE		the name of the parser itself
+ * 	JSMN_CORE_TOKEN		the token type
+ * 	JSMN_CORE_STRICT	1 for strict JSON, 0 for the lenient grammar
+ * 	JSMN_CORE_LINKS		1 to fill in the parent links of JSMN_CORE_TOKEN,
+ * 				0 for a token type without them
+ */
+
+#ifndef __JSMN_CORE_H_
+#define __JSMN_CORE_H_
+
+/**
+ * Lexer states kept in the parser between calls, so that a string or a
+ * primitive cut short by the end of input is resumed rather than rescanned.
+ */
+enum {
+	JSMN_STATE_NONE = 0,
+	JSMN_STATE_PRIMITIVE = 1,
+	JSMN_STATE_STRING = 2,
+	JSMN_STATE_ESCAPE = 3,
+	JSMN_STATE_UNICODE = 4 /* plus the number of hex digits seen */
+};
+
+#endif /* __JSMN_CORE_H_ */
+
+/**
+ * Allocates a fresh unused token from the token pool.
+ */
+static JSMN_CORE_TOKEN *JSMN_CORE(jsmn_alloc_token)(JSMN_CORE_PARSER *parser,
+		JSMN_CORE_TOKEN *tokens, JSMN_CORE_UINT num_tokens) {
+	JSMN_CORE_TOKEN *tok;
+	if (parser->JSMN_TOKNEXT >= num_tokens) {
+		return NULL;
+	}
+	tok = &tokens[parser->JSMN_TOKNEXT++];
+	jsmn_tok_reset(tok);
+#if JSMN_CORE_LINKS
+	tok->JSMN_PARENT = -1;
+#endif
+	return tok;
+}
+
+/**
+ * Returns the innermost object or array that is not closed yet, or -1.
+ */
+static JSMN_CORE_INT JSMN_CORE(jsmn_open_container)(JSMN_CORE_PARSER *parser,
+		JSMN_CORE_TOKEN *tokens) {
+	JSMN_CORE_INT i;
+	if (parser->JSMN_DEPTH == 0) {
+		return -1;
+	}
+	if (parser->JSMN_DEPTH <= JSMN_MAX_DEPTH) {
+		return parser->JSMN_STACK[parser->JSMN_DEPTH - 1];
+	}
+#if JSMN_CORE_LINKS
+	/* Nested deeper than the stack: follow the links up from the superior */
+	for (i = parser->JSMN_TOKSUPER; i != -1 &&
+			jsmn_tok_type(&tokens[i]) >= JSMN_STRING; i = tokens[i].JSMN_PARENT) {
+	}
+	return i;
+#else
+	/* Nested deeper than the stack: look for it among the tokens */
+	for (i = parser->JSMN_TOKNEXT - 1; i >= 0; i--) {
+		if (jsmn_tok_is_open(&tokens[i])) {
+			return i;
+		}
+	}
+	return -1;
+#endif
+}
+
+/**
+ * Fills next available token with JSON primitive.
+ */
+static int JSMN_CORE(jsmn_parse_primitive)(JSMN_CORE_PARSER *parser,
+		const JSMN_CORE_CHAR *js, JSMN_CORE_SIZE len, JSMN_CORE_TOKEN *tokens,
+		JSMN_CORE_UINT num_tokens) {
+	JSMN_CORE_TOKEN *token;
+	JSMN_CORE_INT start;
+
+	/* Resume a primitive cut short by the end of the previous input */
+	start = parser->JSMN_STATE == JSMN_STATE_PRIMITIVE ?
+		(JSMN_CORE_INT)parser->JSMN_TOKSTART : (JSMN_CORE_INT)parser->JSMN_POS;
+	parser->JSMN_STATE = JSMN_STATE_NONE;
+
+	for (; parser->JSMN_POS < len && js[parser->JSMN_POS] != '\0';
+			parser->JSMN_POS++) {
+		switch (js[parser->JSMN_POS]) {
+#if !JSMN_CORE_STRICT
+			/* In strict mode primitive must be followed by "," or "}" or "]" */
+			case ':':
+#endif
+			case '\t' : case '\r' : case '\n' : case ' ' :
+			case ','  : case ']'  : case '}' :
+				goto found;
+		}
+		if ((JSMN_CORE_UNIT)js[parser->JSMN_POS] < 32 ||
+				(JSMN_CORE_UNIT)js[parser->JSMN_POS] >= 127) {
+			parser->JSMN_POS = start;
+			return JSMN_ERROR_INVAL;
+		}
+	}
+#if JSMN_CORE_STRICT
+	/* In strict mode primitive must be followed by a comma/object/array */
+	parser->JSMN_TOKSTART = start;
+	parser->JSMN_STATE = JSMN_STATE_PRIMITIVE;
+	return JSMN_ERROR_PART;
+#endif
+
+found:
+	if (tokens == NULL) {
+		parser->JSMN_POS--;
+		return 0;
+	}
+#ifdef JSMN_CORE_MAX_LEN
+	if (parser->JSMN_POS - start > JSMN_CORE_MAX_LEN) {
+		parser->JSMN_POS = start;
+		return JSMN_ERROR_INVAL;
+	}
+#endif
+	token = JSMN_CORE(jsmn_alloc_token)(parser, tokens, num_tokens);
+	if (token == NULL) {
+		/* Retrying with more tokens picks up right at the delimiter */
+		parser->JSMN_TOKSTART = start;
+		parser->JSMN_STATE = JSMN_STATE_PRIMITIVE;
+		return JSMN_ERROR_NOMEM;
+	}
+	jsmn_tok_fill(token, JSMN_PRIMITIVE, start, parser->JSMN_POS);
+#if JSMN_CORE_LINKS
+	token->JSMN_PARENT = parser->JSMN_TOKSUPER;
+#endif
+	parser->JSMN_POS--;
+	return 0;
+}
+
+/**
+ * Fills next token with JSON string. When the input ends inside the string,
+ * the lexer state is kept in the parser and the next call carries on from
+ * where this one stopped.
+ */
+static int JSMN_CORE(jsmn_parse_string)(JSMN_CORE_PARSER *parser,
+		const JSMN_CORE_CHAR *js, JSMN_CORE_SIZE len, JSMN_CORE_TOKEN *tokens,
+		JSMN_CORE_UINT num_tokens) {
+	JSMN_CORE_TOKEN *token;
+	JSMN_CORE_INT start;
+
+	if (parser->JSMN_STATE == JSMN_STATE_NONE) {
+		/* Skip starting quote */
+		parser->JSMN_TOKSTART = parser->JSMN_POS++;
+		parser->JSMN_STATE = JSMN_STATE_STRING;
+	}
+	start = parser->JSMN_TOKSTART;
+
+	for (; parser->JSMN_POS < len; parser->JSMN_POS++) {
+		JSMN_CORE_CHAR c;
+
+		if (parser->JSMN_STATE == JSMN_STATE_STRING) {
+#if defined(JSMN_CORE_SCAN_CHECKED)
+			{
+				/* Skip string body up to the next character of interest, checked */
+				JSMN_CORE_SIZE pos = parser->JSMN_POS;
+				int r = JSMN_CORE_SCAN_CHECKED(js, len, &pos);
+				if (r < 0 && r != JSMN_ERROR_PART) {
+					parser->JSMN_POS = start;
+					parser->JSMN_STATE = JSMN_STATE_NONE;
+					return r;
+				}
+				parser->JSMN_POS = pos;
+				if (r == JSMN_ERROR_PART || parser->JSMN_POS >= len) {
+					break;
+				}
+			}
+#elif defined(JSMN_CORE_SCAN_STRING)
+			/* Skip plain string body up to the next character of interest */
+			parser->JSMN_POS = JSMN_CORE_SCAN_STRING(js, len, parser->JSMN_POS);
+			if (parser->JSMN_POS >= len) {
+				break;
+			}
+#endif
+			c = js[parser->JSMN_POS];
+			if (c == '\0') {
+				break;
+			}
+
+			/* Quote: end of string */
+			if (c == '\"') {
+				if (tokens == NULL) {
+					parser->JSMN_STATE = JSMN_STATE_NONE;
+					return 0;
+				}
+#ifdef JSMN_CORE_MAX_LEN
+				if (parser->JSMN_POS - start - 1 > JSMN_CORE_MAX_LEN) {
+					parser->JSMN_POS = start;
+					parser->JSMN_STATE = JSMN_STATE_NONE;
+					return JSMN_ERROR_INVAL;
+				}
+#endif
+				token = JSMN_CORE(jsmn_alloc_token)(parser, tokens, num_tokens);
+				if (token == NULL) {
+					/* Retrying with more tokens picks up at this quote */
+					return JSMN_ERROR_NOMEM;
+				}
+				jsmn_tok_fill(token, JSMN_STRING, start + 1, parser->JSMN_POS);
+#if JSMN_CORE_LINKS
+				token->JSMN_PARENT = parser->JSMN_TOKSUPER;
+#endif
+				parser->JSMN_STATE = JSMN_STATE_NONE;
+				return 0;
+			}
+
+			/* Backslash: Quoted symbol expected */
+			if (c == '\\') {
+				parser->JSMN_STATE = JSMN_STATE_ESCAPE;
+			}
+			continue;
+		}
+
+		c = js[parser->JSMN_POS];
+		if (parser->JSMN_STATE == JSMN_STATE_ESCAPE) {
+			switch (c) {
+				/* Allowed escaped symbols */
+				case '\"': case '/' : case '\\' : case 'b' :
+				case 'f' : case 'r' : case 'n'  : case 't' :
+					parser->JSMN_STATE = JSMN_STATE_STRING;
+					break;
+				/* Allows escaped symbol \uXXXX */
+				case 'u':
+					parser->JSMN_STATE = JSMN_STATE_UNICODE;
+					break;
+				/* Unexpected symbol */
+				default:
+					parser->JSMN_POS = start;
+					parser->JSMN_STATE = JSMN_STATE_NONE;
+					return JSMN_ERROR_INVAL;
+			}
+			continue;
+		}
+
+		/* One of the four hex digits of \uXXXX */
+		if (c == '\0') {
+			break;
+		}
+		/* If it isn't a hex character we have an error */
+		if(!((c >= 48 && c <= 57) || /* 0-9 */
+					(c >= 65 && c <= 70) || /* A-F */
+					(c >= 97 && c <= 102))) { /* a-f */
+			parser->JSMN_POS = start;
+			parser->JSMN_STATE = JSMN_STATE_NONE;
+			return JSMN_ERROR_INVAL;
+		}
+		if (++parser->JSMN_STATE == JSMN_STATE_UNICODE + 4) {
+			parser->JSMN_STATE = JSMN_STATE_STRING;
+		}
+	}
+	return JSMN_ERROR_PART;
+}
+
+/**
+ * Parse JSON string and fill tokens.
+ */
+JSMN_CORE_RET JSMN_CORE_PARSE(JSMN_CORE_PARSER *parser, const JSMN_CORE_CHAR *js,
+		JSMN_CORE_SIZE len, JSMN_CORE_TOKEN *tokens, JSMN_CORE_UINT num_tokens) {
+	int r;
+	JSMN_CORE_INT i;
+	JSMN_CORE_TOKEN *token;
+	JSMN_CORE_INT count = parser->JSMN_TOKNEXT;
+#ifdef JSMN_CORE_SKIP_SPACE
+	JSMN_CORE_SPACE_MAP map = { 0 };
+#endif
+
+#ifdef JSMN_CORE_INPUT_LIMIT
+	if (len >= JSMN_CORE_INPUT_LIMIT) {
+		return JSMN_ERROR_INVAL;
+	}
+#endif
+
+	/* Finish a string or primitive cut short by the end of previous input */
+	if (parser->JSMN_STATE != JSMN_STATE_NONE) {
+		if (parser->JSMN_STATE == JSMN_STATE_PRIMITIVE) {
+			r = JSMN_CORE(jsmn_parse_primitive)(parser, js, len, tokens, num_tokens);
+		} else {
+			r = JSMN_CORE(jsmn_parse_string)(parser, js, len, tokens, num_tokens);
+		}
+		if (r < 0) return r;
+		count++;
+		if (parser->JSMN_TOKSUPER != -1 && tokens != NULL)
+			jsmn_tok_add_child(&tokens[parser->JSMN_TOKSUPER]);
+		parser->JSMN_POS++;
+	}
+
+	for (; parser->JSMN_POS < len && js[parser->JSMN_POS] != '\0';
+			parser->JSMN_POS++) {
+		JSMN_CORE_CHAR c;
+
+		c = js[parser->JSMN_POS];
+		switch (c) {
+			case '{': case '[':
+				count++;
+				if (tokens == NULL) {
+					break;
+				}
+				token = JSMN_CORE(jsmn_alloc_token)(parser, tokens, num_tokens);
+				if (token == NULL)
+					return JSMN_ERROR_NOMEM;
+				if (parser->JSMN_TOKSUPER != -1) {
+					jsmn_tok_add_child(&tokens[parser->JSMN_TOKSUPER]);
+#if JSMN_CORE_LINKS
+					token->JSMN_PARENT = parser->JSMN_TOKSUPER;
+#endif
+				}
+				jsmn_tok_fill(token, c == '{' ? JSMN_OBJECT : JSMN_ARRAY,
+						parser->JSMN_POS, -1);
+				parser->JSMN_TOKSUPER = parser->JSMN_TOKNEXT - 1;
+				if (parser->JSMN_DEPTH < JSMN_MAX_DEPTH) {
+					parser->JSMN_STACK[parser->JSMN_DEPTH] = parser->JSMN_TOKSUPER;
+				}
+				parser->JSMN_DEPTH++;
+				break;
+			case '}': case ']':
+				if (tokens == NULL)
+					break;
+				i = JSMN_CORE(jsmn_open_container)(parser, tokens);
+				/* Error if unmatched closing bracket */
+				if (i == -1) return JSMN_ERROR_INVAL;
+				token = &tokens[i];
+				if (jsmn_tok_type(token) != (c == '}' ? JSMN_OBJECT : JSMN_ARRAY)) {
+					return JSMN_ERROR_INVAL;
+				}
+				jsmn_tok_close(token, parser->JSMN_POS + 1, parser->JSMN_TOKNEXT - i);
+				parser->JSMN_DEPTH--;
+#if JSMN_CORE_LINKS
+				parser->JSMN_TOKSUPER = token->JSMN_PARENT;
+#else
+				parser->JSMN_TOKSUPER = JSMN_CORE(jsmn_open_container)(parser, tokens);
+#endif
+				break;
+			case '\"':
+				r = JSMN_CORE(jsmn_parse_string)(parser, js, len, tokens, num_tokens);
+				if (r < 0) return r;
+				count++;
+				if (parser->JSMN_TOKSUPER != -1 && tokens != NULL)
+					jsmn_tok_add_child(&tokens[parser->JSMN_TOKSUPER]);
+				break;
+			case '\t' : case '\r' : case '\n' : case ' ':
+#ifdef JSMN_CORE_SKIP_SPACE
+				/* Jump straight to the next structural or scalar character */
+				parser->JSMN_POS = JSMN_CORE_SKIP_SPACE(&map, js, len,
+						parser->JSMN_POS + 1) - 1;
+#endif
+				break;
+			case ':':
+				parser->JSMN_TOKSUPER = parser->JSMN_TOKNEXT - 1;
+				break;
+			case ',':
+				if (tokens != NULL && parser->JSMN_TOKSUPER != -1 &&
+						jsmn_tok_type(&tokens[parser->JSMN_TOKSUPER]) != JSMN_ARRAY &&
+						jsmn_tok_type(&tokens[parser->JSMN_TOKSUPER]) != JSMN_OBJECT) {
+#if JSMN_CORE_LINKS
+					parser->JSMN_TOKSUPER = tokens[parser->JSMN_TOKSUPER].JSMN_PARENT;
+#else
+					i = JSMN_CORE(jsmn_open_container)(parser, tokens);
+					if (i != -1) {
+						parser->JSMN_TOKSUPER = i;
+					}
+#endif
+				}
+				break;
+#if JSMN_CORE_STRICT
+			/* In strict mode primitives are: numbers and booleans */
+			case '-': case '0': case '1' : case '2': case '3' : case '4':
+			case '5': case '6': case '7' : case '8': case '9':
+			case 't': case 'f': case 'n' :
+				/* And they must not be keys of the object */
+				if (tokens != NULL && parser->JSMN_TOKSUPER != -1) {
+					JSMN_CORE_TOKEN *t = &tokens[parser->JSMN_TOKSUPER];
+					if (jsmn_tok_type(t) == JSMN_OBJECT ||
+							(jsmn_tok_type(t) == JSMN_STRING &&
+							 jsmn_tok_size(t) != 0)) {
+						return JSMN_ERROR_INVAL;
+					}
+				}
+#else
+			/* In non-strict mode every unquoted value is a primitive */
+			default:
+#endif
+				r = JSMN_CORE(jsmn_parse_primitive)(parser, js, len, tokens, num_tokens);
+				if (r < 0) return r;
+				count++;
+				if (parser->JSMN_TOKSUPER != -1 && tokens != NULL)
+					jsmn_tok_add_child(&tokens[parser->JSMN_TOKSUPER]);
+				break;
+
+#if JSMN_CORE_STRICT
+			/* Unexpected char in strict mode */
+			default:
+				return JSMN_ERROR_INVAL;
+#endif
+		}
+	}
+
+	/* Unmatched opened object or array */
+	if (tokens != NULL && parser->JSMN_DEPTH > 0) {
+		return JSMN_ERROR_PART;
+	}
+
+	return count;
+}
+
+#undef JSMN_CORE
+#undef JSMN_CORE_PARSE
+#undef JSMN_CORE_TOKEN
+#undef JSMN_CORE_STRICT
+#undef JSMN_CORE_LINKS
@@ -1,180 +1,323 @@
 #include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/JsmnUefiLib.h>
 
+#ifdef JSMN_SIMD
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define JSMN_SSE2
+#endif
+
+//
+// Whitespace map of one 64-character block of input. Bit i of Mask is set
+// when Js[Base + i] is not JSON whitespace. It only lets the parser skip runs
+// of whitespace; the character it stops on is classified as usual. Positions
+// past the end of input are set as well, so a lookup always stops at Len.
+//
+typedef struct {
+	UINTN Base;
+	UINTN End;
+	UINT64 Mask;
+} JSMN_SPACE_MAP;
+
+#define JSMN_IS_SPACE(c) ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
 
+#ifdef JSMN_SSE2
 //
-// Allocates a fresh unused Token from the Token pull.
+// Compares eight CHAR16 lanes against the whitespace characters.
 //
 STATIC
-JSMNTOK_T*
-JsmnAllocToken (
-	IN JSMN_PARSER *Parser,
-	IN JSMNTOK_T *Tokens,
-	IN UINTN NumTokens
+__m128i
+JsmnSpaceLanes (
+	IN __m128i V
 	)
 {
-	JSMNTOK_T *Tok;
-	if (Parser->Toknext >= NumTokens) {
-		return NULL;
-	}
-	Tok = &Tokens[Parser->Toknext++];
-	Tok->Start = Tok->End = -1;
-	Tok->Size = 0;
-#ifdef JSMN_PARENT_LINKS
-	Tok->Parent = -1;
-#endif
-	return Tok;
+	return _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi16(V, _mm_set1_epi16(' ')),
+				_mm_cmpeq_epi16(V, _mm_set1_epi16('\t'))),
+			_mm_or_si128(_mm_cmpeq_epi16(V, _mm_set1_epi16('\n')),
+				_mm_cmpeq_epi16(V, _mm_set1_epi16('\r'))));
 }
 
 //
-// Fills Token Type and boundaries.
+// Flags the CHAR16 lanes holding a quote, a backslash or a control character.
 //
 STATIC
-VOID
-JsmnFillToken (
-	OUT JSMNTOK_T *Token,
-	IN JSMNTYPE_T Type,
-    IN INT32 Start,
-	IN INT32 End
+__m128i
+JsmnStringLanes (
+	IN __m128i V
 	)
 {
-	Token->Type = Type;
-	Token->Start = Start;
-	Token->End = End;
-	Token->Size = 0;
+	return _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi16(V, _mm_set1_epi16('\"')),
+				_mm_cmpeq_epi16(V, _mm_set1_epi16('\\'))),
+			_mm_cmpeq_epi16(_mm_subs_epu16(V, _mm_set1_epi16(0x1f)),
+				_mm_setzero_si128()));
 }
 
 //
-// Fills next available Token with JSON primitive.
+// Compares sixteen CHAR8 lanes against the whitespace characters.
 //
 STATIC
-UINT32
-JsmnParsePrimitive (
-	IN JSMN_PARSER *Parser,
-	IN CONST CHAR16 *Js,
-	IN UINTN Len,
-	OUT JSMNTOK_T *Tokens,
-	IN UINTN NumTokens
+__m128i
+JsmnSpaceBytes (
+	IN __m128i V
 	)
 {
-	JSMNTOK_T *Token;
-	UINT32 Start;
-
-	Start = Parser->Pos;
+	return _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(V, _mm_set1_epi8(' ')),
+				_mm_cmpeq_epi8(V, _mm_set1_epi8('\t'))),
+			_mm_or_si128(_mm_cmpeq_epi8(V, _mm_set1_epi8('\n')),
+				_mm_cmpeq_epi8(V, _mm_set1_epi8('\r'))));
+}
 
-	for (; Parser->Pos < Len && Js[Parser->Pos] != '\0'; Parser->Pos++) {
-		switch (Js[Parser->Pos]) {
-#ifndef JSMN_STRICT
-			/* In strict mode primitive must be followed by "," or "}" or "]" */
-			case ':':
+//
+// Flags the CHAR8 lanes holding a quote, a backslash or a control character.
+// Bytes of 0x80 and above, UTF-8 text, are plain string body.
+//
+STATIC
+__m128i
+JsmnStringBytes (
+	IN __m128i V
+	)
+{
+	return _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(V, _mm_set1_epi8('\"')),
+				_mm_cmpeq_epi8(V, _mm_set1_epi8('\\'))),
+			_mm_cmpeq_epi8(_mm_subs_epu8(V, _mm_set1_epi8(0x1f)),
+				_mm_setzero_si128()));
+}
 #endif
-			case '\t' : case '\r' : case '\n' : case ' ' :
-			case ','  : case ']'  : case '}' :
-				goto found;
-		}
-		if (Js[Parser->Pos] < 32 || Js[Parser->Pos] >= 127) {
-			Parser->Pos = Start;
-			return JSMN_ERROR_INVAL;
+
+//
+// Builds the whitespace bitmap for the 64 characters at P.
+//
+STATIC
+UINT64
+JsmnWhitespaceBlock (
+	IN CONST CHAR16 *P
+	)
+{
+	UINT64 Ws = 0;
+	UINTN i;
+#ifdef JSMN_SSE2
+	for (i = 0; i < 64; i += 16) {
+		__m128i Lo = JsmnSpaceLanes(_mm_loadu_si128((CONST __m128i *)(P + i)));
+		__m128i Hi = JsmnSpaceLanes(_mm_loadu_si128((CONST __m128i *)(P + i + 8)));
+		Ws |= (UINT64)(UINT16)_mm_movemask_epi8(_mm_packs_epi16(Lo, Hi)) << i;
+	}
+#else
+	/* Scalar fallback */
+	for (i = 0; i < 64; i++) {
+		if (JSMN_IS_SPACE(P[i])) {
+			Ws |= LShiftU64(1, i);
 		}
 	}
-#ifdef JSMN_STRICT
-	/* In strict mode primitive must be followed by a comma/object/array */
-	Parser->Pos = Start;
-	return JSMN_ERROR_PART;
 #endif
+	return Ws;
+}
 
-found:
-	if (Tokens == NULL) {
-		Parser->Pos--;
-		return 0;
+//
+// Builds the whitespace bitmap for the 64 CHAR8 characters at P.
+//
+STATIC
+UINT64
+JsmnWhitespaceBlockAscii (
+	IN CONST CHAR8 *P
+	)
+{
+	UINT64 Ws = 0;
+	UINTN i;
+#ifdef JSMN_SSE2
+	for (i = 0; i < 64; i += 16) {
+		Ws |= (UINT64)(UINT16)_mm_movemask_epi8(
+				JsmnSpaceBytes(_mm_loadu_si128((CONST __m128i *)(P + i)))) << i;
 	}
-	Token = JsmnAllocToken(Parser, Tokens, NumTokens);
-	if (Token == NULL) {
-		Parser->Pos = Start;
-		return JSMN_ERROR_NOMEM;
+#else
+	/* Scalar fallback */
+	for (i = 0; i < 64; i++) {
+		if (JSMN_IS_SPACE(P[i])) {
+			Ws |= LShiftU64(1, i);
+		}
 	}
-	JsmnFillToken(Token, JSMN_PRIMITIVE, Start, Parser->Pos);
-#ifdef JSMN_PARENT_LINKS
-	Token->Parent = Parser->Toksuper;
 #endif
-	Parser->Pos--;
-	return 0;
+	return Ws;
 }
 
+#ifdef JSMN_SSE2
 //
-// Fills next Token with JSON string.
+// Flags, one bit each, which of the 16 characters at P are a quote, a
+// backslash or a control character.
 //
 STATIC
 UINT32
-JsmnParseString (
-	IN JSMN_PARSER *Parser,
-	IN CONST CHAR16 *Js,
-	IN UINTN Len,
-	OUT JSMNTOK_T *Tokens,
-	IN UINTN NumTokens
+JsmnStringBlock (
+	IN CONST CHAR16 *P
 	)
 {
-	JSMNTOK_T *Token;
+	__m128i Lo = JsmnStringLanes(_mm_loadu_si128((CONST __m128i *)P));
+	__m128i Hi = JsmnStringLanes(_mm_loadu_si128((CONST __m128i *)(P + 8)));
+	return (UINT32)_mm_movemask_epi8(_mm_packs_epi16(Lo, Hi));
+}
 
-	UINT32 Start = Parser->Pos;
+//
+// Same for the 16 CHAR8 characters at P; bytes of 0x80 and above are plain
+// string body.
+//
+STATIC
+UINT32
+JsmnStringBlockAscii (
+	IN CONST CHAR8 *P
+	)
+{
+	return (UINT32)_mm_movemask_epi8(
+			JsmnStringBytes(_mm_loadu_si128((CONST __m128i *)P)));
+}
+#endif
 
-	Parser->Pos++;
+//
+// Whitespace and string body scans for CHAR16 and CHAR8 input.
+//
+#define JSMN_CHAR CHAR16
+#define JSMN_UNIT CHAR16
+#define JSMN_FN(Name) Name
+#include "JsmnUefiScan.h"
+#undef JSMN_CHAR
+#undef JSMN_UNIT
+#undef JSMN_FN
 
-	/* Skip Starting quote */
-	for (; Parser->Pos < Len && Js[Parser->Pos] != '\0'; Parser->Pos++) {
-		CHAR16 c = Js[Parser->Pos];
+#define JSMN_CHAR CHAR8
+#define JSMN_UNIT UINT8
+#define JSMN_FN(Name) Name##Ascii
+#include "JsmnUefiScan.h"
+#undef JSMN_CHAR
+#undef JSMN_UNIT
+#undef JSMN_FN
+#endif /* JSMN_SIMD */
 
-		/* Quote: End of string */
-		if (c == '\"') {
-			if (Tokens == NULL) {
-				return 0;
-			}
-			Token = JsmnAllocToken(Parser, Tokens, NumTokens);
-			if (Token == NULL) {
-				Parser->Pos = Start;
-				return JSMN_ERROR_NOMEM;
-			}
-			JsmnFillToken(Token, JSMN_STRING, Start+1, Parser->Pos);
-#ifdef JSMN_PARENT_LINKS
-			Token->Parent = Parser->Toksuper;
+
+//
+// Token updates for the parser core, for plain and linked Tokens alike.
+//
+#define jsmn_tok_type(t) ((t)->Type)
+#define jsmn_tok_size(t) ((t)->Size)
+#define jsmn_tok_reset(t) ((t)->Start = (t)->End = JSMN_UNSET, (t)->Size = 0)
+#define jsmn_tok_fill(t, Ty, S, E) ((t)->Type = (Ty), (t)->Start = (S), \
+		(t)->End = (E), (t)->Size = 0)
+#define jsmn_tok_add_child(t) ((t)->Size++)
+#define jsmn_tok_close(t, E, Span) ((t)->End = (E))
+#define jsmn_tok_is_open(t) ((t)->Start != JSMN_UNSET && (t)->End == JSMN_UNSET)
+
+//
+// The parser itself, built from the same core as jsmn_parse() for CHAR16
+// and CHAR8 input, each with either grammar and either Token layout.
+//
+#define JSMN_CORE_PARSER JSMN_PARSER
+#define JSMN_CORE_INT INT32
+#define JSMN_CORE_UINT UINT32
+#define JSMN_CORE_SIZE UINTN
+#define JSMN_CORE_RET UINT32 EFIAPI
+#define JSMN_POS Pos
+#define JSMN_TOKNEXT Toknext
+#define JSMN_TOKSUPER Toksuper
+#define JSMN_STATE State
+#define JSMN_TOKSTART Tokstart
+#define JSMN_DEPTH Depth
+#define JSMN_STACK Stack
+#define JSMN_PARENT Parent
+#ifdef JSMN_PACKED
+// Every offset must fit in 16 bits, with 0xFFFF left for unset ones
+#define JSMN_CORE_INPUT_LIMIT JSMN_UNSET
 #endif
-			return 0;
-		}
 
-		/* Backslash: Quoted symbol expected */
-		if (c == '\\' && Parser->Pos + 1 < Len) {
-			UINT32 i;
-			Parser->Pos++;
-			switch (Js[Parser->Pos]) {
-				/* Allowed escaped symbols */
-				case '\"': case '/' : case '\\' : case 'b' :
-				case 'f' : case 'r' : case 'n'  : case 't' :
-					break;
-				/* Allows escaped symbol \uXXXX */
-				case 'u':
-					Parser->Pos++;
-					for(i = 0; i < 4 && Parser->Pos < Len && Js[Parser->Pos] != '\0'; i++) {
-						/* If it isn't a hex character we have an error */
-						if(!((Js[Parser->Pos] >= 48 && Js[Parser->Pos] <= 57) || /* 0-9 */
-									(Js[Parser->Pos] >= 65 && Js[Parser->Pos] <= 70) || /* A-F */
-									(Js[Parser->Pos] >= 97 && Js[Parser->Pos] <= 102))) { /* a-f */
-							Parser->Pos = Start;
-							return JSMN_ERROR_INVAL;
-						}
-						Parser->Pos++;
-					}
-					Parser->Pos--;
-					break;
-				/* Unexpected symbol */
-				default:
-					Parser->Pos = Start;
-					return JSMN_ERROR_INVAL;
-			}
-		}
-	}
-	Parser->Pos = Start;
-	return JSMN_ERROR_PART;
-}
+#define JSMN_CORE_CHAR CHAR16
+#define JSMN_CORE_UNIT CHAR16
+#ifdef JSMN_SIMD
+#define JSMN_CORE_SPACE_MAP JSMN_SPACE_MAP
+#define JSMN_CORE_SKIP_SPACE JsmnSkipWhitespace
+#define JSMN_CORE_SCAN_STRING JsmnScanString
+#endif
+
+#define JSMN_CORE(Name) Name##_strict
+#define JSMN_CORE_PARSE JsmnParserStrict
+#define JSMN_CORE_TOKEN JSMNPLAINTOK_T
+#define JSMN_CORE_STRICT 1
+#define JSMN_CORE_LINKS 0
+#include <jsmn_core.h>
+
+#define JSMN_CORE(Name) Name##_lenient
+#define JSMN_CORE_PARSE JsmnParserLenient
+#define JSMN_CORE_TOKEN JSMNPLAINTOK_T
+#define JSMN_CORE_STRICT 0
+#define JSMN_CORE_LINKS 0
+#include <jsmn_core.h>
+
+#define JSMN_CORE(Name) Name##_strict_links
+#define JSMN_CORE_PARSE JsmnParserStrictLinks
+#define JSMN_CORE_TOKEN JSMNLINKTOK_T
+#define JSMN_CORE_STRICT 1
+#define JSMN_CORE_LINKS 1
+#include <jsmn_core.h>
+
+#define JSMN_CORE(Name) Name##_lenient_links
+#define JSMN_CORE_PARSE JsmnParserLenientLinks
+#define JSMN_CORE_TOKEN JSMNLINKTOK_T
+#define JSMN_CORE_STRICT 0
+#define JSMN_CORE_LINKS 1
+#include <jsmn_core.h>
+
+#undef JSMN_CORE_CHAR
+#undef JSMN_CORE_UNIT
+#undef JSMN_CORE_SKIP_SPACE
+#undef JSMN_CORE_SCAN_STRING
+#define JSMN_CORE_CHAR CHAR8
+#define JSMN_CORE_UNIT UINT8
+#ifdef JSMN_SIMD
+#define JSMN_CORE_SKIP_SPACE JsmnSkipWhitespaceAscii
+#define JSMN_CORE_SCAN_STRING JsmnScanStringAscii
+#endif
+
+#define JSMN_CORE(Name) Name##_ascii_strict
+#define JSMN_CORE_PARSE JsmnParserAsciiStrict
+#define JSMN_CORE_TOKEN JSMNPLAINTOK_T
+#define JSMN_CORE_STRICT 1
+#define JSMN_CORE_LINKS 0
+#include <jsmn_core.h>
+
+#define JSMN_CORE(Name) Name##_ascii_lenient
+#define JSMN_CORE_PARSE JsmnParserAsciiLenient
+#define JSMN_CORE_TOKEN JSMNPLAINTOK_T
+#define JSMN_CORE_STRICT 0
+#define JSMN_CORE_LINKS 0
+#include <jsmn_core.h>
+
+#define JSMN_CORE(Name) Name##_ascii_strict_links
+#define JSMN_CORE_PARSE JsmnParserAsciiStrictLinks
+#define JSMN_CORE_TOKEN JSMNLINKTOK_T
+#define JSMN_CORE_STRICT 1
+#define JSMN_CORE_LINKS 1
+#include <jsmn_core.h>
+
+#define JSMN_CORE(Name) Name##_ascii_lenient_links
+#define JSMN_CORE_PARSE JsmnParserAsciiLenientLinks
+#define JSMN_CORE_TOKEN JSMNLINKTOK_T
+#define JSMN_CORE_STRICT 0
+#define JSMN_CORE_LINKS 1
+#include <jsmn_core.h>
+
+//
+// The variant JSMN_STRICT and JSMN_PARENT_LINKS select
+//
+#if defined(JSMN_STRICT) && defined(JSMN_PARENT_LINKS)
+#define JSMN_VARIANT(Name) Name##StrictLinks
+#elif defined(JSMN_STRICT)
+#define JSMN_VARIANT(Name) Name##Strict
+#elif defined(JSMN_PARENT_LINKS)
+#define JSMN_VARIANT(Name) Name##LenientLinks
+#else
+#define JSMN_VARIANT(Name) Name##Lenient
+#endif
 
 /**
 	Run JSON Parser. It parses a JSON data string into and array of Tokens, each describing
@@ -183,12 +326,13 @@ JsmnParseString (
 	This function has the responsibility to parse JSON string and fill Tokens.
 
 	@param  Parser		A pointer to a object Parser containing an array of Tokens.
-	@param  Js			A pointer to a Null-terminated unicode :q.
+	@param  Js			A pointer to a Null-terminated unicode string.
 	@param  Len			The Length of input string to be parsed.
 	@param  Tokens		A pointer to a an array of Tokens parsed from input string.
 	@param  NumTokens	The maximum number of Tokens that is assumed to be parsed.
 
 	@return The number of parsed Tokens or a Jsmn error while try to parse the input string.
+			With JSMN_PACKED, input of 0xFFFF characters or more is JSMN_ERROR_INVAL.
 
 **/
 UINT32
@@ -200,157 +344,608 @@ JsmnParser (
 	OUT JSMNTOK_T *Tokens,
 	IN UINT32 NumTokens
 	)
+{
+	return JSMN_VARIANT(JsmnParser)(Parser, Js, Len, Tokens, NumTokens);
+}
+
+/**
+	Run JSON Parser over CHAR8 input, producing the Tokens JsmnParser() does for
+	the same input widened to CHAR16.
+
+	@param  Parser		A pointer to a object Parser containing an array of Tokens.
+	@param  Js			A pointer to the ASCII or UTF-8 input.
+	@param  Len			The Length of input in bytes.
+	@param  Tokens		A pointer to a an array of Tokens parsed from input string.
+	@param  NumTokens	The maximum number of Tokens that is assumed to be parsed.
+
+	@return The number of parsed Tokens or a Jsmn error while try to parse the input string.
+
+**/
+UINT32
+EFIAPI
+JsmnParserAscii (
+	IN JSMN_PARSER *Parser,
+	IN CONST CHAR8 *Js,
+	IN UINTN Len,
+	OUT JSMNTOK_T *Tokens,
+	IN UINT32 NumTokens
+	)
+{
+	return JSMN_VARIANT(JsmnParserAscii)(Parser, Js, Len, Tokens, NumTokens);
+}
+
+/**
+	Run JSON Parser with a pool-allocated array of Tokens that grows as needed.
+
+	When the array is full its size is doubled with ReallocatePool() and
+	parsing carries on from where it stopped.
+
+	@param  Parser		A pointer to a object Parser containing an array of Tokens.
+	@param  Js			A pointer to a Null-terminated unicode string.
+	@param  Len			The Length of input string to be parsed.
+	@param  Tokens		On input, the current pool-allocated array of Tokens or NULL.
+						On output, the possibly moved array, to be freed with FreePool().
+	@param  NumTokens	On input, the number of Tokens in the array. On output, its
+						new size.
+
+	@return The number of parsed Tokens or a Jsmn error while try to parse the input
+			string. JSMN_ERROR_NOMEM means that the pool could not be grown.
+
+**/
+INT32
+EFIAPI
+JsmnParserGrow (
+	IN JSMN_PARSER *Parser,
+	IN CONST CHAR16 *Js,
+	IN UINTN Len,
+	IN OUT JSMNTOK_T **Tokens,
+	IN OUT UINT32 *NumTokens
+	)
 {
 	INT32 r;
-	INT32 i;
-	JSMNTOK_T *Token;
-	INT32 Count = Parser->Toknext;
-
-	for (; Parser->Pos < Len && Js[Parser->Pos] != '\0'; Parser->Pos++) {
-		CHAR16 c;
-		JSMNTYPE_T Type;
-
-		c = Js[Parser->Pos];
-		switch (c) {
-			case '{': case '[':
-				Count++;
-				if (Tokens == NULL) {
-					break;
-				}
-				Token = JsmnAllocToken(Parser, Tokens, NumTokens);
-				if (Token == NULL)
-					return JSMN_ERROR_NOMEM;
-				if (Parser->Toksuper != -1) {
-					Tokens[Parser->Toksuper].Size++;
-#ifdef JSMN_PARENT_LINKS
-					Token->Parent = Parser->Toksuper;
-#endif
-				}
-				Token->Type = (c == '{' ? JSMN_OBJECT : JSMN_ARRAY);
-				Token->Start = Parser->Pos;
-				Parser->Toksuper = Parser->Toknext - 1;
-				break;
-			case '}': case ']':
-				if (Tokens == NULL)
-					break;
-				Type = (c == '}' ? JSMN_OBJECT : JSMN_ARRAY);
-#ifdef JSMN_PARENT_LINKS
-				if (Parser->Toknext < 1) {
-					return JSMN_ERROR_INVAL;
-				}
-				Token = &Tokens[Parser->Toknext - 1];
-				for (;;) {
-					if (Token->Start != -1 && Token->End == -1) {
-						if (Token->Type != Type) {
-							return JSMN_ERROR_INVAL;
-						}
-						Token->End = Parser->Pos + 1;
-						Parser->Toksuper = Token->Parent;
-						break;
-					}
-					if (Token->Parent == -1) {
-						if(Token->Type != Type || Parser->Toksuper == -1) {
-							return JSMN_ERROR_INVAL;
-						}
-						break;
-					}
-					Token = &Tokens[Token->Parent];
-				}
-#else
-				for (i = Parser->Toknext - 1; i >= 0; i--) {
-					Token = &Tokens[i];
-					if (Token->Start != -1 && Token->End == -1) {
-						if (Token->Type != Type) {
-							return JSMN_ERROR_INVAL;
-						}
-						Parser->Toksuper = -1;
-						Token->End = Parser->Pos + 1;
-						break;
-					}
-				}
-				/* Error if unmatched closing bracket */
-				if (i == -1) return JSMN_ERROR_INVAL;
-				for (; i >= 0; i--) {
-					Token = &Tokens[i];
-					if (Token->Start != -1 && Token->End == -1) {
-						Parser->Toksuper = i;
-						break;
-					}
-				}
-#endif
-				break;
-			case '\"':
-				r = JsmnParseString(Parser, Js, Len, Tokens, NumTokens);
-				if (r < 0) return r;
-				Count++;
-				if (Parser->Toksuper != -1 && Tokens != NULL)
-					Tokens[Parser->Toksuper].Size++;
-				break;
-			case '\t' : case '\r' : case '\n' : case ' ':
-				break;
-			case ':':
-				Parser->Toksuper = Parser->Toknext - 1;
-				break;
-			case ',':
-				if (Tokens != NULL && Parser->Toksuper != -1 &&
-						Tokens[Parser->Toksuper].Type != JSMN_ARRAY &&
-						Tokens[Parser->Toksuper].Type != JSMN_OBJECT) {
-#ifdef JSMN_PARENT_LINKS
-					Parser->Toksuper = Tokens[Parser->Toksuper].Parent;
-#else
-					for (i = Parser->Toknext - 1; i >= 0; i--) {
-						if (Tokens[i].Type == JSMN_ARRAY || Tokens[i].Type == JSMN_OBJECT) {
-							if (Tokens[i].Start != -1 && Tokens[i].End == -1) {
-								Parser->Toksuper = i;
-								break;
-							}
-						}
-					}
-#endif
-				}
-				break;
-#ifdef JSMN_STRICT
-			/* In strict mode primitives are: numbers and booleans */
-			case '-': case '0': case '1' : case '2': case '3' : case '4':
-			case '5': case '6': case '7' : case '8': case '9':
-			case 't': case 'f': case 'n' :
-				/* And they must not be keys of the object */
-				if (Tokens != NULL && Parser->Toksuper != -1) {
-					JSMNTOK_T *t = &Tokens[Parser->Toksuper];
-					if (t->Type == JSMN_OBJECT ||
-							(t->Type == JSMN_STRING && t->Size != 0)) {
-						return JSMN_ERROR_INVAL;
-					}
-				}
+	UINT32 n;
+	JSMNTOK_T *t;
+
+	for (;;) {
+		/* A NULL array would make JsmnParser() count Tokens instead */
+		if (*Tokens != NULL) {
+			r = (INT32)JsmnParser(Parser, Js, Len, *Tokens, *NumTokens);
+			if (r != JSMN_ERROR_NOMEM) {
+				return r;
+			}
+		}
+		/* The Parser stopped at the Token it could not store, resume there */
+		if (*Tokens == NULL || *NumTokens < 8) {
+			n = 16;
+		} else if (*NumTokens > MAX_INT32 / 2 ||
+				(UINTN)*NumTokens * 2 > MAX_UINTN / sizeof(JSMNTOK_T)) {
+			/* Doubled, the count would not fit an INT32 or its bytes a UINTN */
+			return JSMN_ERROR_NOMEM;
+		} else {
+			n = *NumTokens * 2;
+		}
+		t = ReallocatePool(*Tokens == NULL ? 0 : *NumTokens * sizeof(JSMNTOK_T),
+				n * sizeof(JSMNTOK_T), *Tokens);
+		if (t == NULL) {
+			return JSMN_ERROR_NOMEM;
+		}
+		*Tokens = t;
+		*NumTokens = n;
+	}
+}
+
+//
+// FNV-1a hash of a key, seeded with the index of its object.
+//
+STATIC
+UINT32
+JsmnHash (
+	IN CONST CHAR16 *Key,
+	IN UINTN Len,
+	IN INT32 Object
+	)
+{
+	UINT32 h = (2166136261u ^ (UINT32)Object) * 16777619u;
+	UINTN i;
+	for (i = 0; i < Len; i++) {
+		h = (h ^ Key[i]) * 16777619u;
+	}
+	return h ^ h >> 16;
+}
+
+//
+// Returns the number of Tokens in the value starting at Tokens[0], going by
+// their sizes: a key counts its value, a container its children.
+//
+STATIC
+UINT32
+JsmnValueTokens (
+	IN CONST JSMNTOK_T *Tokens,
+	IN UINT32 NumTokens
+	)
+{
+	UINT32 i;
+	INT32 Pending = 1;
+	for (i = 0; i < NumTokens && Pending > 0; i++) {
+		Pending += Tokens[i].Size - 1;
+	}
+	return i;
+}
+
+/**
+	Compute the number of slots of a key index for an array of Tokens.
+
+	@param  Tokens		A pointer to an array of parsed Tokens.
+	@param  NumTokens	The number of parsed Tokens.
+
+	@return Twice the number of keys, rounded up to a power of two.
+
+**/
+UINT32
+EFIAPI
+JsmnKeyIndexSize (
+	IN CONST JSMNTOK_T *Tokens,
+	IN UINT32 NumTokens
+	)
+{
+	UINT32 i, Keys = 0, Size = 1;
+	for (i = 0; i < NumTokens; i++) {
+		if (Tokens[i].Type == JSMN_OBJECT) {
+			Keys += Tokens[i].Size;
+		}
+	}
+	while (Size < Keys * 2 && (UINT32)(Size << 1) != 0) {
+		Size <<= 1;
+	}
+	return Size;
+}
+
+/**
+	Index the keys of every object of a parsed Token array, going from one key
+	to the next over the Tokens of its value.
+
+	@param  Index		A key index whose Size comes from JsmnKeyIndexSize() and
+						whose Slots are filled in.
+	@param  Js			A pointer to the parsed unicode string.
+	@param  Tokens		A pointer to an array of parsed Tokens.
+	@param  NumTokens	The number of parsed Tokens.
+
+	@return The number of keys, or JSMN_ERROR_NOMEM if the slots are too few.
+
+**/
+INT32
+EFIAPI
+JsmnBuildKeyIndex (
+	IN OUT JSMN_KEY_INDEX *Index,
+	IN CONST CHAR16 *Js,
+	IN CONST JSMNTOK_T *Tokens,
+	IN UINT32 NumTokens
+	)
+{
+	UINT32 i, j, k, h, Keys = 0, Mask = Index->Size - 1;
+
+	if (Index->Size == 0 || (Index->Size & Mask) != 0) {
+		return JSMN_ERROR_NOMEM;
+	}
+	for (h = 0; h < Index->Size; h++) {
+		Index->Slots[h].Key = 0;
+	}
+	for (i = 0; i < NumTokens; i++) {
+		if (Tokens[i].Type != JSMN_OBJECT) {
+			continue;
+		}
+		k = i + 1;
+		for (j = 0; j < (UINT32)Tokens[i].Size && k < NumTokens; j++) {
+			CONST JSMNTOK_T *Key = &Tokens[k];
+			/* An object or array as key (non-strict) hashes as empty */
+			UINTN Len = Key->End != JSMN_UNSET && Key->End > Key->Start ?
+				(UINTN)(Key->End - Key->Start) : 0;
+			/* Keep a free slot, where lookups stop */
+			if (Keys + 1 >= Index->Size) {
+				return JSMN_ERROR_NOMEM;
+			}
+			h = JsmnHash(Js + Key->Start, Len, (INT32)i) & Mask;
+			while (Index->Slots[h].Key != 0) {
+				h = (h + 1) & Mask;
+			}
+			Index->Slots[h].Object = (INT32)i;
+			Index->Slots[h].Key = (INT32)k;
+			Keys++;
+			k += JsmnValueTokens(Key, NumTokens - k);
+		}
+	}
+	return (INT32)Keys;
+}
+
+/**
+	Look a key up in an object in O(1) on average.
+
+	@param  Index		A key index built by JsmnBuildKeyIndex().
+	@param  Js			A pointer to the parsed unicode string.
+	@param  Tokens		A pointer to the array of parsed Tokens.
+	@param  Object		The index of the object Token.
+	@param  Key			A pointer to a Null-terminated unicode key.
+
+	@return The index of the value of the key, of the first one if the key is
+			repeated, or -1.
+
+**/
+INT32
+EFIAPI
+JsmnLookup (
+	IN CONST JSMN_KEY_INDEX *Index,
+	IN CONST CHAR16 *Js,
+	IN CONST JSMNTOK_T *Tokens,
+	IN INT32 Object,
+	IN CONST CHAR16 *Key
+	)
+{
+	UINT32 h, Mask = Index->Size - 1;
+	UINTN i, Len = 0;
+	INT32 k;
+
+	while (Key[Len] != 0) {
+		Len++;
+	}
+	for (h = JsmnHash(Key, Len, Object) & Mask; (k = Index->Slots[h].Key) != 0;
+			h = (h + 1) & Mask) {
+		CONST JSMNTOK_T *t = &Tokens[k];
+		if (Index->Slots[h].Object != Object ||
+				t->End == JSMN_UNSET || (UINTN)(t->End - t->Start) != Len) {
+			continue;
+		}
+		for (i = 0; i < Len && Js[t->Start + i] == Key[i]; i++);
+		if (i == Len) {
+			return t->Size > 0 ? k + 1 : -1;
+		}
+	}
+	return -1;
+}
+
+//
+// Packs the eight characters at P into the bytes of *Chunk, the first one in
+// the low byte, and tells whether they are all ASCII digits.
+//
+STATIC
+BOOLEAN
+JsmnLoadEightDigits (
+	IN CONST CHAR16 *P,
+	OUT UINT64 *Chunk
+	)
+{
+	UINT64 v = 0;
+	UINT16 High = 0;
+	INTN i;
+
+	for (i = 7; i >= 0; i--) {
+		High |= P[i] >> 8;
+		v = v << 8 | (UINT8)P[i];
+	}
+	*Chunk = v;
+	return High == 0 && ((v & 0xF0F0F0F0F0F0F0F0ULL) |
+			(((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+		0x3333333333333333ULL;
+}
+
+//
+// Value of eight ASCII digits packed by JsmnLoadEightDigits(): pairs, then
+// quads, then the whole in three multiplications.
+//
+STATIC
+UINT32
+JsmnEightDigits (
+	IN UINT64 v
+	)
+{
+	CONST UINT64 Mask = 0x000000FF000000FFULL;
+	CONST UINT64 Mul1 = 100 + (1000000ULL << 32);
+	CONST UINT64 Mul2 = 1 + (10000ULL << 32);
+
+	v -= 0x3030303030303030ULL;
+	v = v * 10 + (v >> 8);
+	return (UINT32)(((v & Mask) * Mul1 + ((v >> 16) & Mask) * Mul2) >> 32);
+}
+
+//
+// Reads a primitive Token as an optional minus sign and digits without
+// leading zeros, eight digits at a time while they fit.
+//
+STATIC
+INT32
+JsmnReadInteger (
+	IN CONST CHAR16 *Js,
+	IN CONST JSMNTOK_T *Token,
+	OUT BOOLEAN *Negative,
+	OUT UINT64 *Value
+	)
+{
+	CONST CHAR16 *p, *End;
+	UINT64 v = 0, Chunk;
+	UINTN n = 0;
+	BOOLEAN Over = FALSE;
+
+	if (Token->Type != JSMN_PRIMITIVE) {
+		return JSMN_ERROR_INVAL;
+	}
+	p = Js + Token->Start;
+	End = Js + Token->End;
+	*Negative = p < End && *p == '-';
+	p += *Negative;
+	if (p == End || *p < '0' || *p > '9' || (*p == '0' && End - p > 1)) {
+		return JSMN_ERROR_INVAL;
+	}
+	while (End - p >= 8 && n <= 11 && JsmnLoadEightDigits(p, &Chunk)) {
+		v = v * 100000000 + JsmnEightDigits(Chunk);
+		p += 8;
+		n += 8;
+	}
+	for (; p < End && *p >= '0' && *p <= '9'; p++) {
+		if (v > (MAX_UINT64 - (*p - '0')) / 10) {
+			Over = TRUE;
+		}
+		v = v * 10 + (*p - '0');
+	}
+	if (p != End) {
+		return JSMN_ERROR_INVAL;
+	}
+	*Value = v;
+	return Over ? JSMN_ERROR_RANGE : 0;
+}
+
+/**
+	Read a primitive token as a signed 64-bit integer, without strtol() or any
+	other library function.
+
+	@param  Js			A pointer to the parsed unicode string.
+	@param  Token		A pointer to a primitive token.
+	@param  Value		On success, the value of the number.
+
+	@return 0, JSMN_ERROR_INVAL if the token is not a JSON number without
+			fraction and exponent, or JSMN_ERROR_RANGE if it does not fit.
+
+**/
+INT32
+EFIAPI
+JsmnGetInt64 (
+	IN CONST CHAR16 *Js,
+	IN CONST JSMNTOK_T *Token,
+	OUT INT64 *Value
+	)
+{
+	UINT64 v;
+	BOOLEAN Negative;
+	INT32 r = JsmnReadInteger(Js, Token, &Negative, &v);
+
+	if (r < 0) {
+		return r;
+	}
+	if (v > (UINT64)MAX_INT64 + Negative) {
+		return JSMN_ERROR_RANGE;
+	}
+	// -2^63 itself does not fit before it is negated
+	*Value = Negative && v > 0 ? -(INT64)(v - 1) - 1 : (INT64)v;
+	return 0;
+}
+
+/**
+	Read a primitive token as an unsigned 64-bit integer, without strtoul() or
+	any other library function.
+
+	@param  Js			A pointer to the parsed unicode string.
+	@param  Token		A pointer to a primitive token.
+	@param  Value		On success, the value of the number.
+
+	@return 0, JSMN_ERROR_INVAL if the token is not a JSON number without
+			fraction and exponent, or JSMN_ERROR_RANGE if it does not fit or
+			is negative.
+
+**/
+INT32
+EFIAPI
+JsmnGetUint64 (
+	IN CONST CHAR16 *Js,
+	IN CONST JSMNTOK_T *Token,
+	OUT UINT64 *Value
+	)
+{
+	UINT64 v;
+	BOOLEAN Negative;
+	INT32 r = JsmnReadInteger(Js, Token, &Negative, &v);
+
+	if (r < 0) {
+		return r;
+	}
+	if (Negative && v > 0) {
+		return JSMN_ERROR_RANGE;
+	}
+	*Value = v;
+	return 0;
+}
+
+//
+// Returns the position of the first backslash at or after Pos, or End if
+// there is none.
+//
+STATIC
+UINTN
+JsmnNextEscape (
+	IN CONST CHAR16 *Js,
+	IN UINTN Pos,
+	IN UINTN End
+	)
+{
+#ifdef JSMN_SIMD
+	// The scan also stops at control characters (non-strict), which are plain
+	while ((Pos = JsmnScanString(Js, End, Pos)) < End && Js[Pos] != '\\') {
+		Pos++;
+	}
 #else
-			/* In non-strict mode every unquoted value is a primitive */
-			default:
+	while (Pos < End && Js[Pos] != '\\') {
+		Pos++;
+	}
 #endif
-				r = JsmnParsePrimitive(Parser, Js, Len, Tokens, NumTokens);
-				if (r < 0) return r;
-				Count++;
-				if (Parser->Toksuper != -1 && Tokens != NULL)
-					Tokens[Parser->Toksuper].Size++;
-				break;
-
-#ifdef JSMN_STRICT
-			/* Unexpected char in strict mode */
-			default:
-				return JSMN_ERROR_INVAL;
+	return Pos;
+}
+
+//
+// Copies N code units of string body that has no escapes.
+//
+STATIC
+VOID
+JsmnCopyRun (
+	OUT CHAR16 *Dst,
+	IN CONST CHAR16 *Src,
+	IN UINTN N
+	)
+{
+	UINTN k = 0;
+#ifdef JSMN_SSE2
+	for (; k + 8 <= N; k += 8) {
+		_mm_storeu_si128((__m128i *)(Dst + k),
+				_mm_loadu_si128((CONST __m128i *)(Src + k)));
+	}
 #endif
-		}
+	for (; k < N; k++) {
+		Dst[k] = Src[k];
 	}
+}
 
-	if (Tokens != NULL) {
-		for (i = Parser->Toknext - 1; i >= 0; i--) {
-			/* Unmatched opened object or array */
-			if (Tokens[i].Start != -1 && Tokens[i].End == -1) {
-				return JSMN_ERROR_PART;
+//
+// Decodes the escape sequence at Js[*Pos] into one code unit and moves *Pos
+// past it. A "\uXXXX" escape is the code unit it names, so a surrogate pair
+// stays two units. A malformed escape is taken as it is written.
+//
+STATIC
+CHAR16
+JsmnDecodeEscape (
+	IN CONST CHAR16 *Js,
+	IN OUT UINTN *Pos,
+	IN UINTN End
+	)
+{
+	UINTN i = *Pos;
+	UINTN k;
+	CHAR16 c, Unit = 0;
+
+	if (i + 1 >= End) {
+		(*Pos)++;
+		return Js[i];
+	}
+	switch (Js[i + 1]) {
+		case 'b': c = '\b'; break;
+		case 'f': c = '\f'; break;
+		case 'n': c = '\n'; break;
+		case 'r': c = '\r'; break;
+		case 't': c = '\t'; break;
+		case 'u':
+			if (i + 6 > End) {
+				(*Pos)++;
+				return Js[i];
 			}
-		}
+			for (k = i + 2; k < i + 6; k++) {
+				c = Js[k];
+				if (c >= '0' && c <= '9') {
+					Unit = (CHAR16)(Unit << 4 | (c - '0'));
+				} else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+					Unit = (CHAR16)(Unit << 4 | ((c | 0x20) - 'a' + 10));
+				} else {
+					(*Pos)++;
+					return Js[i];
+				}
+			}
+			*Pos += 6;
+			return Unit;
+		default: c = Js[i + 1]; break;
+	}
+	*Pos += 2;
+	return c;
+}
+
+/**
+	Count the code units a string token takes once its escapes are decoded,
+	so that the buffer of JsmnUnescape() can be sized exactly beforehand.
+
+	@param  Js			A pointer to the parsed unicode string.
+	@param  Token		A pointer to a string or primitive token.
+
+	@return The number of code units, or JSMN_ERROR_INVAL for an object or
+			array token.
+
+**/
+INT32
+EFIAPI
+JsmnUnescapedLength (
+	IN CONST CHAR16 *Js,
+	IN CONST JSMNTOK_T *Token
+	)
+{
+	UINTN Pos, End;
+	INT32 n;
+
+	if (Token->Type < JSMN_STRING) {
+		return JSMN_ERROR_INVAL;
+	}
+	Pos = Token->Start;
+	End = Token->End;
+	// Every escape is one code unit, the rest is copied as it is
+	n = (INT32)(End - Pos);
+	while ((Pos = JsmnNextEscape(Js, Pos, End)) < End) {
+		UINTN Escape = Pos;
+		JsmnDecodeEscape(Js, &Pos, End);
+		n -= (INT32)(Pos - Escape) - 1;
 	}
+	return n;
+}
 
-	return Count;
+/**
+	Decode the escapes of a string token into a buffer, copying the runs
+	without escapes whole. A surrogate pair written as two "\uXXXX" escapes
+	is stored as the two code units. No Null terminator is added.
+
+	@param  Js			A pointer to the parsed unicode string.
+	@param  Token		A pointer to a string or primitive token.
+	@param  Buffer		A pointer to the buffer to fill.
+	@param  Size		The number of CHAR16 the buffer holds.
+
+	@return The number of code units stored, JSMN_ERROR_NOMEM if they are more
+			than Size (what fits may have been stored), or JSMN_ERROR_INVAL for
+			an object or array token.
+
+**/
+INT32
+EFIAPI
+JsmnUnescape (
+	IN CONST CHAR16 *Js,
+	IN CONST JSMNTOK_T *Token,
+	OUT CHAR16 *Buffer,
+	IN UINTN Size
+	)
+{
+	UINTN Pos, Run, End;
+	UINTN n = 0;
+
+	if (Token->Type < JSMN_STRING) {
+		return JSMN_ERROR_INVAL;
+	}
+	Pos = Token->Start;
+	End = Token->End;
+	while (Pos < End) {
+		Run = JsmnNextEscape(Js, Pos, End);
+		if (Run - Pos > Size - n) {
+			return JSMN_ERROR_NOMEM;
+		}
+		JsmnCopyRun(Buffer + n, Js + Pos, Run - Pos);
+		n += Run - Pos;
+		if (Run == End) {
+			break;
+		}
+		if (n == Size) {
+			return JSMN_ERROR_NOMEM;
+		}
+		Pos = Run;
+		Buffer[n++] = JsmnDecodeEscape(Js, &Pos, End);
+	}
+	return (INT32)n;
 }
 
 /**
@@ -368,4 +963,7 @@ JsmnInit (
 	Parser->Pos = 0;
 	Parser->Toknext = 0;
 	Parser->Toksuper = -1;
+	Parser->State = 0;
+	Parser->Tokstart = 0;
+	Parser->Depth = 0;
 }
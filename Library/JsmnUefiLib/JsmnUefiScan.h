@@ -0,0 +1,91 @@
+//
+// Whitespace and string body scans of JsmnUefiLib, written once for any
+// character type and included by JsmnUefiLib.c for each of them in
+// JSMN_SIMD builds, with:
+// 	JSMN_CHAR	the character type of the input, CHAR16 or CHAR8
+// 	JSMN_UNIT	... as an unsigned type
+// 	JSMN_FN(Name)	the name of function Name for that type
+//
+
+//
+// (Re)builds the map for the block containing Pos.
+//
+STATIC
+VOID
+JSMN_FN(JsmnMapBlock) (
+	OUT JSMN_SPACE_MAP *Map,
+	IN CONST JSMN_CHAR *Js,
+	IN UINTN Len,
+	IN UINTN Pos
+	)
+{
+	UINTN i;
+	Map->Base = Pos & ~(UINTN)63;
+	Map->End = Map->Base + 64;
+	if (Map->End <= Len) {
+		Map->Mask = ~JSMN_FN(JsmnWhitespaceBlock)(Js + Map->Base);
+		return;
+	}
+	/* Tail block: classify what is left and mark the rest as a stop */
+	Map->Mask = ~(UINT64)0;
+	for (i = Map->Base; i < Len; i++) {
+		if (JSMN_IS_SPACE(Js[i])) {
+			Map->Mask &= ~LShiftU64(1, i - Map->Base);
+		}
+	}
+}
+
+//
+// Returns the position of the first non-whitespace character at or after
+// Pos, or Len if there is none.
+//
+STATIC
+UINTN
+JSMN_FN(JsmnSkipWhitespace) (
+	IN OUT JSMN_SPACE_MAP *Map,
+	IN CONST JSMN_CHAR *Js,
+	IN UINTN Len,
+	IN UINTN Pos
+	)
+{
+	while (Pos < Len) {
+		UINT64 Mask;
+		if (Pos < Map->Base || Pos >= Map->End) {
+			JSMN_FN(JsmnMapBlock)(Map, Js, Len, Pos);
+		}
+		Mask = RShiftU64(Map->Mask, Pos - Map->Base);
+		if (Mask != 0) {
+			return Pos + LowBitSet64(Mask);
+		}
+		Pos = Map->End;
+	}
+	return Len;
+}
+
+//
+// Returns the position of the first quote, backslash or control character at
+// or after Pos, or Len if there is none.
+//
+STATIC
+UINTN
+JSMN_FN(JsmnScanString) (
+	IN CONST JSMN_CHAR *Js,
+	IN UINTN Len,
+	IN UINTN Pos
+	)
+{
+#ifdef JSMN_SSE2
+	for (; Pos + 16 <= Len; Pos += 16) {
+		UINT32 Bits = JSMN_FN(JsmnStringBlock)(Js + Pos);
+		if (Bits != 0) {
+			return Pos + LowBitSet32(Bits);
+		}
+	}
+#endif
+	for (; Pos < Len; Pos++) {
+		if (Js[Pos] == '\"' || Js[Pos] == '\\' || (JSMN_UNIT)Js[Pos] < 0x20) {
+			return Pos;
+		}
+	}
+	return Len;
+}
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../jsmn.h"
+#include "../jsmn_parallel.h"
+
+/*
+ * Batch benchmark: parses a set of independent request bodies of mixed sizes,
+ * most of them small, some of a few KiB and a few of 64 KiB, first one after
+ * the other with jsmn_parse_grow() on the calling thread, then with
+ * jsmn_parse_batch() on pools of 1 to 64 threads. Times are wall-clock.
+ *
+ * Usage: bench_batch [documents]
+ */
+
+#define ROUNDS 5
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *realloc_tokens(void *ptr, size_t size, void *data) {
+	(void)data;
+	return realloc(ptr, size);
+}
+
+/* A body of about size bytes: an order with an array of items */
+static char *body(size_t size, int seed, size_t *len) {
+	char *js = malloc(size + 256);
+	size_t n = 0;
+	int i;
+
+	n += sprintf(js + n, "{\"order\": %d, \"items\": [", seed);
+	for (i = 0; n < size; i++) {
+		n += sprintf(js + n, "%s{\"sku\": \"A-%05d\", \"qty\": %d, \"price\": %d.%02d}",
+				i ? ", " : "", (seed + i) % 100000, i % 9 + 1, i % 500, i % 100);
+	}
+	n += sprintf(js + n, "]}");
+	*len = n;
+	return js;
+}
+
+static void report(const char *name, double elapsed, size_t docs,
+		size_t bytes, double serial) {
+	printf("%-12s %9.2f ms %9.0f docs/s %8.1f MB/s %6.2fx\n", name,
+			1000.0 * elapsed, docs / elapsed, bytes / 1e6 / elapsed,
+			serial / elapsed);
+}
+
+int main(int argc, char *argv[]) {
+	size_t num_docs = argc > 1 ? (size_t)atol(argv[1]) : 20000;
+	jsmndoc_t *docs = malloc(num_docs * sizeof(jsmndoc_t));
+	jsmntok_t *tok = NULL;
+	jsmnuint_t tokcount = 0;
+	jsmn_pool *pool;
+	size_t i, bytes = 0;
+	unsigned int threads;
+	double start, serial;
+	char name[16];
+	int round;
+
+	/* 80% of 200 bytes, 15% of 4 KiB, 5% of 64 KiB */
+	for (i = 0; i < num_docs; i++) {
+		size_t size = i % 20 == 0 ? 65536 : i % 20 < 4 ? 4096 : 200;
+		docs[i].js = body(size, (int)i, &docs[i].len);
+		bytes += docs[i].len;
+	}
+	printf("%lu documents, %.1f MB\n", (unsigned long)num_docs, bytes / 1e6);
+
+	start = now();
+	for (round = 0; round < ROUNDS; round++) {
+		for (i = 0; i < num_docs; i++) {
+			jsmn_parser p;
+			jsmn_init(&p);
+			jsmn_parse_grow(&p, docs[i].js, docs[i].len, &tok, &tokcount,
+					realloc_tokens, NULL);
+		}
+	}
+	serial = (now() - start) / ROUNDS;
+	report("serial", serial, num_docs, bytes, serial);
+
+	for (threads = 1; threads <= 64; threads *= 2) {
+		pool = jsmn_pool_new(threads);
+		if (pool == NULL) {
+			fprintf(stderr, "out of memory\n");
+			return 1;
+		}
+		/* The first batch sizes the arenas */
+		jsmn_parse_batch(pool, docs, num_docs);
+		start = now();
+		for (round = 0; round < ROUNDS; round++) {
+			if (jsmn_parse_batch(pool, docs, num_docs) != num_docs) {
+				fprintf(stderr, "parse error\n");
+				return 1;
+			}
+		}
+		sprintf(name, "%u threads", threads);
+		report(name, (now() - start) / ROUNDS, num_docs, bytes, serial);
+		jsmn_pool_free(pool);
+	}
+
+	for (i = 0; i < num_docs; i++) {
+		free((char *)docs[i].js);
+	}
+	free(docs);
+	free(tok);
+	return 0;
+}
@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../jsmn.h"
+
+/*
+ * Cursor benchmark: parses a large document, an array of records each with a
+ * nested payload and an "id" member last, then picks out the ids by walking
+ * with a jsmncursor_t. This is compared with skipping over values by
+ * counting their children recursively, the way dump() in example/jsondump.c
+ * does. Built once without and once with JSMN_SPANS (bench_cursor_spans),
+ * where a sibling is one step away.
+ *
+ * Usage: bench_cursor [records]
+ */
+
+#define PASSES 5
+
+static char *synthesize(int records, size_t *len) {
+	char *js = malloc((size_t)records * 400 + 16);
+	size_t n = 0;
+	int i, j;
+
+	js[n++] = '[';
+	for (i = 0; i < records; i++) {
+		n += sprintf(js + n, "%s{\"payload\": {\"tags\": [\"a\", \"b\", \"c\"], "
+				"\"pos\": [", i ? "," : "");
+		for (j = 0; j < 16; j++) {
+			n += sprintf(js + n, "%s[%d, %d]", j ? ", " : "", (i + j) % 7, j);
+		}
+		n += sprintf(js + n, "], \"ok\": true}, \"name\": \"r%d\", \"id\": %d}", i, i);
+	}
+	js[n++] = ']';
+	*len = n;
+	return js;
+}
+
+/* Number of tokens in the value at t, counting children one by one */
+static int skip(const jsmntok_t *t) {
+	int i, j = 1;
+	if (jsmn_tok_type(t) == JSMN_OBJECT) {
+		for (i = 0; i < jsmn_tok_size(t); i++) {
+			j += 1 + skip(t + j + 1);
+		}
+	} else if (jsmn_tok_type(t) == JSMN_ARRAY) {
+		for (i = 0; i < jsmn_tok_size(t); i++) {
+			j += skip(t + j);
+		}
+	}
+	return j;
+}
+
+static int member(const char *js, const jsmntok_t *key, const char *name) {
+	size_t len = strlen(name);
+	return (size_t)(jsmn_tok_end(key) - jsmn_tok_start(key)) == len &&
+		strncmp(js + jsmn_tok_start(key), name, len) == 0;
+}
+
+static long ids_by_counting(const char *js, const jsmntok_t *t) {
+	long sum = 0;
+	int i, j, k = 1, v;
+
+	for (i = 0; i < jsmn_tok_size(&t[0]); i++) {
+		v = k + 1;
+		for (j = 0; j < jsmn_tok_size(&t[k]); j++) {
+			if (member(js, &t[v], "id")) {
+				sum += atoi(js + jsmn_tok_start(&t[v + 1]));
+			}
+			v += 1 + skip(&t[v + 1]);
+		}
+		k += skip(&t[k]);
+	}
+	return sum;
+}
+
+static long ids_by_cursor(const char *js, const jsmntok_t *t, jsmnuint_t n) {
+	jsmncursor_t c;
+	jsmnint_t record, key;
+	long sum = 0;
+
+	jsmn_cursor_init(&c, t, n);
+	for (record = jsmn_cursor_first_child(&c); record >= 0;
+			record = jsmn_cursor_next_sibling(&c)) {
+		for (key = jsmn_cursor_first_child(&c); key >= 0;
+				key = jsmn_cursor_next_sibling(&c)) {
+			if (member(js, &t[key], "id")) {
+				sum += atoi(js + jsmn_tok_start(&t[key + 1]));
+			}
+		}
+		jsmn_cursor_parent(&c);
+	}
+	return sum;
+}
+
+int main(int argc, char *argv[]) {
+	int records = argc > 1 ? atoi(argv[1]) : 200000;
+	size_t len;
+	char *js = synthesize(records, &len);
+	jsmntok_t *tok = malloc(sizeof(jsmntok_t) * 80 * (size_t)records + 16);
+	jsmn_parser p;
+	clock_t start, counting, cursor;
+	long a = 0, b = 0;
+	jsmnint_t r;
+	int pass;
+
+	jsmn_init(&p);
+	r = jsmn_parse(&p, js, len, tok, 80 * records + 16);
+	if (r < 0) {
+		fprintf(stderr, "parse error %d\n", (int)r);
+		return 1;
+	}
+
+	start = clock();
+	for (pass = 0; pass < PASSES; pass++) {
+		a += ids_by_counting(js, tok);
+	}
+	counting = clock() - start;
+	start = clock();
+	for (pass = 0; pass < PASSES; pass++) {
+		b += ids_by_cursor(js, tok, r);
+	}
+	cursor = clock() - start;
+	if (a != b) {
+		fprintf(stderr, "results differ: %ld %ld\n", a, b);
+		return 1;
+	}
+
+	printf("%d records, %ld tokens\n", records, (long)r);
+	printf("counting %9.2f ms/pass\n", 1000.0 * counting / CLOCKS_PER_SEC / PASSES);
+	printf("cursor   %9.2f ms/pass\n", 1000.0 * cursor / CLOCKS_PER_SEC / PASSES);
+	free(tok);
+	free(js);
+	return 0;
+}
@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "../jsmn.h"
+#include "../jsmn_file.h"
+
+/*
+ * File benchmark: parses a file the way example/jsondump.c reads stdin,
+ * fread() in BUFSIZ chunks appended to a growing heap copy, and then with
+ * jsmn_parse_file(), which maps it and parses it in place. Each run happens
+ * in its own process so that their peak RSS can be told apart.
+ *
+ * Usage: bench_file [file.json]
+ * Without an argument, a 64 MiB synthetic document of records with long
+ * strings is written to /tmp.
+ */
+
+/* Private memory in use once the document is parsed, in KiB */
+static long anon_kib = -1;
+
+/*
+ * Reads RssAnon from /proc: unlike the peak RSS, it leaves out the mapped
+ * file, whose pages stay in the page cache and are shared.
+ */
+static void measure_anon(void) {
+	char line[128];
+	FILE *f = fopen("/proc/self/status", "r");
+
+	if (f == NULL) {
+		return;
+	}
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (strncmp(line, "RssAnon:", 8) == 0) {
+			anon_kib = atol(line + 8);
+		}
+	}
+	fclose(f);
+}
+
+static void *realloc_tokens(void *ptr, size_t size, void *data) {
+	(void)data;
+	return realloc(ptr, size);
+}
+
+static jsmnint_t parse_fread(const char *path) {
+	FILE *f = fopen(path, "rb");
+	char buf[BUFSIZ];
+	char *js = NULL;
+	size_t jslen = 0, n;
+	jsmn_parser p;
+	jsmntok_t *tok = NULL;
+	jsmnuint_t tokcount = 0;
+	jsmnint_t r = JSMN_ERROR_PART;
+
+	if (f == NULL) {
+		return JSMN_ERROR_FILE;
+	}
+	jsmn_init(&p);
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+		js = realloc(js, jslen + n + 1);
+		strncpy(js + jslen, buf, n);
+		jslen += n;
+		r = jsmn_parse_grow(&p, js, jslen, &tok, &tokcount,
+				realloc_tokens, NULL);
+	}
+	fclose(f);
+	measure_anon();
+	free(js);
+	free(tok);
+	return r;
+}
+
+static jsmnint_t parse_mmap(const char *path) {
+	const char *js;
+	size_t jslen;
+	jsmn_parser p;
+	jsmntok_t *tok = NULL;
+	jsmnuint_t tokcount = 0;
+	jsmnint_t r;
+
+	jsmn_init(&p);
+	r = jsmn_parse_file(&p, path, &js, &jslen, &tok, &tokcount,
+			realloc_tokens, NULL);
+	measure_anon();
+	jsmn_unmap_file(js, jslen);
+	free(tok);
+	return r;
+}
+
+static void run(const char *name, jsmnint_t (*parse)(const char *),
+		const char *path) {
+	struct rusage ru;
+	clock_t start;
+	jsmnint_t r;
+	int status;
+
+	fflush(stdout);
+	if (fork() == 0) {
+		start = clock();
+		r = parse(path);
+		start = clock() - start;
+		getrusage(RUSAGE_SELF, &ru);
+		printf("%-6s %10ld tokens %9.2f ms %8ld KiB peak RSS %8ld KiB private\n",
+				name, (long)r, 1000.0 * start / CLOCKS_PER_SEC,
+				(long)ru.ru_maxrss, anon_kib);
+		exit(0);
+	}
+	wait(&status);
+}
+
+int main(int argc, char *argv[]) {
+	char tmp[] = "/tmp/bench_fileXXXXXX";
+	const char *path = tmp;
+	size_t n = 0;
+	FILE *f;
+	int i;
+
+	if (argc > 1) {
+		path = argv[1];
+	} else {
+		f = fdopen(mkstemp(tmp), "wb");
+		if (f == NULL) {
+			perror(tmp);
+			return 1;
+		}
+		fputc('[', f);
+		for (i = 0; n < (size_t)64 << 20; i++) {
+			n += fprintf(f, "%s{\"id\": %d, \"text\": \"%0500d\"}",
+					i ? ",\n  " : "\n  ", i, i);
+		}
+		fputs("]\n", f);
+		fclose(f);
+	}
+	run("fread", parse_fread, path);
+	run("mmap", parse_mmap, path);
+	if (path == tmp) {
+		unlink(tmp);
+	}
+	return 0;
+}
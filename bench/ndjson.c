@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../jsmn.h"
+
+/*
+ * NDJSON benchmark: feeds newline-delimited records through a 64 KiB buffer,
+ * the way a log pipeline reads them, carrying a record cut by the end of the
+ * buffer over to the next fill. Records are parsed either one line at a time,
+ * finding each newline first and calling jsmn_init() and jsmn_parse() on it,
+ * or a whole buffer at a time with jsmn_parse_records().
+ *
+ * Usage: bench_ndjson [file.ndjson]
+ * Without an argument, a million synthetic log records are used.
+ */
+
+#define BUFFER (64 * 1024)
+#define MAX_TOKENS 1024
+
+static char *synthesize(size_t *len) {
+	size_t cap = (size_t)200 << 20, n = 0;
+	char *js = malloc(cap);
+	int i;
+
+	for (i = 0; i < 1000000; i++) {
+		n += sprintf(js + n, "{\"ts\": %d, \"level\": \"%s\", \"msg\": \"request %d done\", "
+				"\"tags\": [\"web\", \"eu-%d\"], \"ms\": %d.%d}\n",
+				1600000000 + i, i % 10 ? "info" : "warn", i, i % 4, i % 997, i % 10);
+	}
+	*len = n;
+	return js;
+}
+
+static char *load(const char *path, size_t *len) {
+	FILE *f = fopen(path, "rb");
+	char *js;
+	long size;
+
+	if (f == NULL) {
+		return NULL;
+	}
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	js = malloc(size + 1);
+	*len = fread(js, 1, size, f);
+	fclose(f);
+	return js;
+}
+
+static jsmntok_t tok[MAX_TOKENS];
+static jsmnrecord_t rec[MAX_TOKENS];
+
+/* Parses the records in buf[0..len), returns how many bytes were consumed */
+static size_t by_line(const char *buf, size_t len, int last, unsigned long *records) {
+	const char *p = buf, *end = buf + len, *nl;
+	jsmn_parser parser;
+
+	while (p < end) {
+		nl = memchr(p, '\n', end - p);
+		if (nl == NULL) {
+			if (!last) {
+				break;
+			}
+			nl = end;
+		}
+		jsmn_init(&parser);
+		if (jsmn_parse(&parser, p, nl - p, tok, MAX_TOKENS) > 0) {
+			(*records)++;
+		}
+		p = nl + 1 < end ? nl + 1 : end;
+	}
+	return p - buf;
+}
+
+static size_t by_batch(const char *buf, size_t len, int last, unsigned long *records) {
+	size_t used, total = 0;
+	jsmnint_t r;
+
+	(void)last;
+	do {
+		r = jsmn_parse_records(buf + total, len - total, tok, MAX_TOKENS,
+				rec, MAX_TOKENS, &used);
+		if (r > 0) {
+			*records += r;
+		}
+		total += used;
+	} while (r > 0 && total < len);
+	return total;
+}
+
+static void run(const char *name, const char *js, size_t len,
+		size_t (*parse)(const char *, size_t, int, unsigned long *)) {
+	static char buf[BUFFER];
+	size_t fill = 0, pos = 0, used;
+	unsigned long records = 0;
+	clock_t start, elapsed;
+
+	start = clock();
+	while (pos < len || fill > 0) {
+		size_t n = len - pos < BUFFER - fill ? len - pos : BUFFER - fill;
+		memcpy(buf + fill, js + pos, n);
+		fill += n;
+		pos += n;
+		used = parse(buf, fill, pos == len, &records);
+		if (used == 0 && pos == len) {
+			break;
+		}
+		memmove(buf, buf + used, fill - used);
+		fill -= used;
+	}
+	elapsed = clock() - start;
+
+	printf("%-8s %9lu records %8.2f ms %7.2f M records/s %7.1f MB/s\n", name,
+			records, 1000.0 * elapsed / CLOCKS_PER_SEC,
+			records / 1e6 / ((double)elapsed / CLOCKS_PER_SEC),
+			len / 1e6 / ((double)elapsed / CLOCKS_PER_SEC));
+}
+
+int main(int argc, char *argv[]) {
+	size_t len;
+	char *js;
+
+	js = argc > 1 ? load(argv[1], &len) : synthesize(&len);
+	if (js == NULL) {
+		fprintf(stderr, "%s: cannot read\n", argv[1]);
+		return 1;
+	}
+	run("by line", js, len, by_line);
+	run("batch", js, len, by_batch);
+	free(js);
+	return 0;
+}
@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../jsmn_number.h"
+
+/*
+ * Number decoding benchmark: an array of doubles printed in full (%.17g),
+ * short decimals such as prices, and integers, read back from the tokens
+ * with strtod()/strtoll() and with jsmn_get_double()/jsmn_get_int64(). The
+ * results must be the same bit for bit.
+ *
+ * Usage: bench_number [numbers]
+ */
+
+#define PASSES 5
+
+static char *synthesize(int count, size_t *len) {
+	char *js = malloc((size_t)count * 32 + 16);
+	size_t n = 0;
+	uint64_t bits;
+	double d;
+	int i;
+
+	srand(1);
+	js[n++] = '[';
+	for (i = 0; i < count; i++) {
+		if (i > 0) {
+			js[n++] = ',';
+		}
+		switch (i % 3) {
+			case 0:
+				do {
+					bits = (uint64_t)rand() << 62 ^ (uint64_t)rand() << 31 ^
+						(uint64_t)rand();
+				} while ((bits >> 52 & 0x7FF) == 0x7FF);
+				memcpy(&d, &bits, sizeof(d));
+				n += sprintf(js + n, "%.17g", d);
+				break;
+			case 1:
+				n += sprintf(js + n, "%d.%02d", rand() % 10000, rand() % 100);
+				break;
+			default:
+				n += sprintf(js + n, "%d", rand() - RAND_MAX / 2);
+				break;
+		}
+	}
+	js[n++] = ']';
+	js[n] = '\0';
+	*len = n;
+	return js;
+}
+
+int main(int argc, char *argv[]) {
+	int count = argc > 1 ? atoi(argv[1]) : 1000000;
+	size_t len;
+	char *js = synthesize(count, &len);
+	jsmntok_t *tok = malloc(sizeof(jsmntok_t) * ((size_t)count + 1));
+	double *a = malloc(sizeof(double) * (size_t)count);
+	double *b = malloc(sizeof(double) * (size_t)count);
+	int64_t ia = 0, ib = 0, v;
+	jsmn_parser p;
+	clock_t start, libc_double, jsmn_double, libc_int, jsmn_int;
+	int pass, i, r;
+
+	jsmn_init(&p);
+	r = jsmn_parse(&p, js, len, tok, count + 1);
+	if (r != count + 1) {
+		fprintf(stderr, "parse error %d\n", r);
+		return 1;
+	}
+
+	start = clock();
+	for (pass = 0; pass < PASSES; pass++) {
+		for (i = 0; i < count; i++) {
+			a[i] = strtod(js + jsmn_tok_start(&tok[i + 1]), NULL);
+		}
+	}
+	libc_double = clock() - start;
+	start = clock();
+	for (pass = 0; pass < PASSES; pass++) {
+		for (i = 0; i < count; i++) {
+			jsmn_get_double(js, &tok[i + 1], &b[i]);
+		}
+	}
+	jsmn_double = clock() - start;
+	if (memcmp(a, b, sizeof(double) * (size_t)count) != 0) {
+		fprintf(stderr, "doubles differ\n");
+		return 1;
+	}
+
+	start = clock();
+	for (pass = 0; pass < PASSES; pass++) {
+		for (i = 2; i < count; i += 3) {
+			ia += strtoll(js + jsmn_tok_start(&tok[i + 1]), NULL, 10);
+		}
+	}
+	libc_int = clock() - start;
+	start = clock();
+	for (pass = 0; pass < PASSES; pass++) {
+		for (i = 2; i < count; i += 3) {
+			jsmn_get_int64(js, &tok[i + 1], &v);
+			ib += v;
+		}
+	}
+	jsmn_int = clock() - start;
+	if (ia != ib) {
+		fprintf(stderr, "integers differ\n");
+		return 1;
+	}
+
+	printf("%d numbers\n", count);
+	printf("strtod          %7.2f ns/number\n",
+			1e9 * libc_double / CLOCKS_PER_SEC / PASSES / count);
+	printf("jsmn_get_double %7.2f ns/number\n",
+			1e9 * jsmn_double / CLOCKS_PER_SEC / PASSES / count);
+	printf("strtoll         %7.2f ns/number\n",
+			1e9 * libc_int / CLOCKS_PER_SEC / PASSES / (count / 3));
+	printf("jsmn_get_int64  %7.2f ns/number\n",
+			1e9 * jsmn_int / CLOCKS_PER_SEC / PASSES / (count / 3));
+	free(a);
+	free(b);
+	free(tok);
+	free(js);
+	return 0;
+}
@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../jsmn.h"
+
+/*
+ * Selective parsing benchmark: a response object of about 200 KB, a few
+ * fields around a big "items" array, from which three fields are wanted.
+ * jsmn_parse() fills tokens for the whole object and the fields are then
+ * found with jsmn_path_eval(); jsmn_parse_select() skips what the paths do
+ * not select. Prints the tokens used and the time per document.
+ *
+ * Usage: bench_select [items]
+ */
+
+#define PASSES 200
+
+static char *synthesize(int items, size_t *len) {
+	char *js = malloc((size_t)items * 300 + 256);
+	size_t n = 0;
+	int i;
+
+	n += sprintf(js + n, "{\"id\": 42, \"user\": {\"name\": \"ann\", "
+			"\"roles\": [\"admin\", \"dev\"]}, \"items\": [");
+	for (i = 0; i < items; i++) {
+		n += sprintf(js + n, "%s{\"sku\": \"s%06d\", \"qty\": %d, \"price\": "
+				"%d.%02d, \"tags\": [\"x\", \"y\", \"z\"], \"note\": \"a \\\"quoted\\\" "
+				"note, with [brackets] and {braces}\", \"dims\": {\"w\": 1, "
+				"\"h\": 2, \"d\": 3}}", i ? ", " : "", i, i % 9, i, i % 100);
+	}
+	n += sprintf(js + n, "], \"status\": \"ok\"}");
+	*len = n;
+	return js;
+}
+
+int main(int argc, char *argv[]) {
+	int items = argc > 1 ? atoi(argv[1]) : 1000;
+	static const char *exprs[] = { "/id", "/user/name", "/status" };
+	size_t len, max;
+	char *js = synthesize(items, &len);
+	jsmntok_t *tok;
+	jsmnpath_t paths[3];
+	jsmnint_t m, found[2][3];
+	jsmn_parser p;
+	clock_t start, full, select;
+	jsmnint_t r = 0, s = 0;
+	int pass, i;
+
+	max = 32 * (size_t)items + 64;
+	tok = malloc(sizeof(jsmntok_t) * max);
+	for (i = 0; i < 3; i++) {
+		jsmn_path_compile(&paths[i], exprs[i]);
+	}
+
+	start = clock();
+	for (pass = 0; pass < PASSES; pass++) {
+		jsmn_init(&p);
+		r = jsmn_parse(&p, js, len, tok, max);
+		for (i = 0; i < 3; i++) {
+			found[0][i] = jsmn_path_eval(&paths[i], js, tok, r, &m, 1) == 1 ?
+				jsmn_tok_start(&tok[m]) : -1;
+		}
+	}
+	full = clock() - start;
+	start = clock();
+	for (pass = 0; pass < PASSES; pass++) {
+		s = jsmn_parse_select(js, len, paths, 3, tok, max);
+		for (i = 0; i < 3; i++) {
+			found[1][i] = jsmn_path_eval(&paths[i], js, tok, s, &m, 1) == 1 ?
+				jsmn_tok_start(&tok[m]) : -1;
+		}
+	}
+	select = clock() - start;
+	if (r < 0 || s < 0 || memcmp(found[0], found[1], sizeof(found[0])) != 0) {
+		fprintf(stderr, "results differ: %ld %ld\n", (long)r, (long)s);
+		return 1;
+	}
+
+	printf("%lu bytes\n", (unsigned long)len);
+	printf("jsmn_parse        %7ld tokens %9.3f ms/doc\n", (long)r,
+			1000.0 * full / CLOCKS_PER_SEC / PASSES);
+	printf("jsmn_parse_select %7ld tokens %9.3f ms/doc\n", (long)s,
+			1000.0 * select / CLOCKS_PER_SEC / PASSES);
+	free(tok);
+	free(js);
+	return 0;
+}
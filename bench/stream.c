@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../jsmn.h"
+
+/*
+ * Streaming benchmark: feeds a document to jsmn_parse in 4 KiB chunks, the
+ * way example/jsondump.c does, calling the parser again after every chunk.
+ * Each call only has to look at the new bytes, so the time per input byte
+ * should stay flat as the document grows.
+ *
+ * Usage: bench_stream [file.json ...]
+ * Without arguments, synthetic documents of 1 to 32 MiB are used.
+ */
+
+#define CHUNK 4096
+
+/*
+ * Synthetic documents: an array of nested records, or a flat array of
+ * scalars where the only open container is the top-level array.
+ */
+static char *synthesize(int flat, size_t size, size_t *len) {
+	char *js = malloc(size + 256);
+	size_t n = 0;
+	int i = 0;
+
+	js[n++] = '[';
+	while (n < size) {
+		if (flat) {
+			n += sprintf(js + n, i % 2 ? "%s%d" : "%s\"s%d\"", i ? ", " : "", i);
+		} else {
+			n += sprintf(js + n, "%s{\"id\": %d, \"name\": \"item %d\", "
+					"\"tags\": [\"a\", \"b\"], \"nested\": {\"x\": [1, [2, {\"y\": null}]]}}",
+					i ? ",\n  " : "\n  ", i, i);
+		}
+		i++;
+	}
+	js[n++] = ']';
+	js[n] = '\0';
+	*len = n;
+	return js;
+}
+
+static char *load(const char *path, size_t *len) {
+	FILE *f = fopen(path, "rb");
+	char *js;
+	long size;
+
+	if (f == NULL) {
+		return NULL;
+	}
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	js = malloc(size + 1);
+	*len = fread(js, 1, size, f);
+	js[*len] = '\0';
+	fclose(f);
+	return js;
+}
+
+static void run(const char *name, const char *js, size_t len) {
+	jsmn_parser p;
+	jsmntok_t *tok;
+	unsigned int tokcount;
+	size_t avail = 0;
+	unsigned long calls = 0;
+	clock_t start, elapsed;
+	int r;
+
+	/* Without JSMN_STRICT a primitive cut by a chunk end becomes two tokens */
+	tokcount = jsmn_validate(js, len) + len / CHUNK + 1;
+	tok = malloc(sizeof(*tok) * tokcount);
+
+	jsmn_init(&p);
+	start = clock();
+	do {
+		avail = avail + CHUNK < len ? avail + CHUNK : len;
+		r = jsmn_parse(&p, js, avail, tok, tokcount);
+		calls++;
+	} while (r == JSMN_ERROR_PART && avail < len);
+	elapsed = clock() - start;
+
+	printf("%-24s %10lu bytes %8lu calls %9d tokens %8.2f ms %7.2f ns/byte\n",
+			name, (unsigned long)len, calls, r,
+			1000.0 * elapsed / CLOCKS_PER_SEC,
+			1e9 * elapsed / CLOCKS_PER_SEC / len);
+	free(tok);
+}
+
+int main(int argc, char *argv[]) {
+	char name[32];
+	size_t len;
+	char *js;
+	int i;
+
+	if (argc > 1) {
+		for (i = 1; i < argc; i++) {
+			js = load(argv[i], &len);
+			if (js == NULL) {
+				fprintf(stderr, "%s: cannot read\n", argv[i]);
+				return 1;
+			}
+			run(argv[i], js, len);
+			free(js);
+		}
+		return 0;
+	}
+	for (i = 1; i <= 32; i *= 2) {
+		js = synthesize(0, (size_t)i << 20, &len);
+		sprintf(name, "records %d MiB", i);
+		run(name, js, len);
+		free(js);
+	}
+	for (i = 1; i <= 32; i *= 2) {
+		js = synthesize(1, (size_t)i << 20, &len);
+		sprintf(name, "flat array %d MiB", i);
+		run(name, js, len);
+		free(js);
+	}
+	return 0;
+}
@@ -0,0 +1,269 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../jsmn.h"
+
+/*
+ * Parser benchmark suite: generates a set of synthetic corpora of different
+ * shapes and times jsmn_parse over each. `make bench` builds it once per
+ * build variant (default, JSMN_STRICT, JSMN_PARENT_LINKS and both) and runs
+ * them all.
+ *
+ * Every corpus is parsed in ROUNDS rounds, each repeating the parse until
+ * at least ROUND_NS has passed; the median round is reported, which holds
+ * steady on a busy machine where the mean does not. Output is one
+ * tab-separated line per corpus, so two runs can be compared with diff or
+ * a spreadsheet:
+ *
+ *	variant corpus bytes tokens mb_per_s tokens_per_s ns_per_token
+ *
+ * Usage: bench_suite [-H] [size]
+ * -H prints the column names first; size is the corpus size in bytes,
+ * 4 MiB by default.
+ */
+
+#if defined(JSMN_STRICT) && defined(JSMN_PARENT_LINKS)
+#define VARIANT "strict_links"
+#elif defined(JSMN_STRICT)
+#define VARIANT "strict"
+#elif defined(JSMN_PARENT_LINKS)
+#define VARIANT "links"
+#else
+#define VARIANT "default"
+#endif
+
+#define ROUNDS 9
+#define ROUND_NS 50000000.0
+
+typedef struct {
+	char *js;
+	size_t len;
+	size_t cap;
+} buffer;
+
+static void put(buffer *b, const char *fmt, ...) {
+	va_list ap;
+	int n;
+
+	for (;;) {
+		va_start(ap, fmt);
+		n = vsnprintf(b->js + b->len, b->cap - b->len, fmt, ap);
+		va_end(ap);
+		if (n >= 0 && (size_t)n < b->cap - b->len) {
+			b->len += n;
+			return;
+		}
+		b->cap *= 2;
+		b->js = realloc(b->js, b->cap);
+	}
+}
+
+/* Deterministic pseudo-random numbers, the same on every run */
+static unsigned long long seed;
+
+static unsigned long next(void) {
+	seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+	return (unsigned long)(seed >> 33);
+}
+
+/* A flat array of small numbers and literals */
+static void gen_wide(buffer *b, size_t size) {
+	static const char *lit[] = { "true", "false", "null", "0", "1" };
+	int i;
+
+	put(b, "[");
+	for (i = 0; b->len < size; i++) {
+		put(b, "%s%s", i ? "," : "", lit[next() % 5]);
+	}
+	put(b, "]");
+}
+
+/* Chains of nested objects and arrays, deeper than JSMN_MAX_DEPTH */
+static void gen_deep(buffer *b, size_t size) {
+	int i, j, depth;
+
+	put(b, "[");
+	for (i = 0; b->len < size; i++) {
+		depth = 8 + (int)(next() % 56);
+		put(b, "%s", i ? "," : "");
+		for (j = 0; j < depth; j++) {
+			put(b, j % 2 ? "[" : "{\"k\":");
+		}
+		put(b, "%d", i);
+		for (j = depth - 1; j >= 0; j--) {
+			put(b, j % 2 ? "]" : "}");
+		}
+	}
+	put(b, "]");
+}
+
+/* Long strings with an occasional escape */
+static void gen_strings(buffer *b, size_t size) {
+	int i, j, n;
+
+	put(b, "[");
+	for (i = 0; b->len < size; i++) {
+		n = 16 + (int)(next() % 400);
+		put(b, "%s\"", i ? "," : "");
+		for (j = 0; j < n; j++) {
+			if (next() % 64 == 0) {
+				put(b, next() % 2 ? "\\n" : "\\u00e9");
+			} else {
+				put(b, "%c", "abcdefghij klmnopqrstuvwxyz"[next() % 27]);
+			}
+		}
+		put(b, "\"");
+	}
+	put(b, "]");
+}
+
+/* Integers, decimals and exponents */
+static void gen_numbers(buffer *b, size_t size) {
+	int i;
+
+	put(b, "[");
+	for (i = 0; b->len < size; i++) {
+		switch (next() % 3) {
+		case 0:
+			put(b, "%s%ld", i ? "," : "", (long)next() - 0x3fffffff);
+			break;
+		case 1:
+			put(b, "%s%.6f", i ? "," : "", (double)next() / 1000.0);
+			break;
+		default:
+			put(b, "%s%.3e", i ? "," : "", (double)next() * 1e-9);
+			break;
+		}
+	}
+	put(b, "]");
+}
+
+/* Indented records, mostly whitespace between tokens */
+static void gen_pretty(buffer *b, size_t size) {
+	int i;
+
+	put(b, "[\n");
+	for (i = 0; b->len < size; i++) {
+		put(b, "%s    {\n        \"id\": %d,\n        \"name\": \"user%lu\",\n"
+				"        \"score\": %lu.%02lu,\n        \"active\": %s,\n"
+				"        \"tags\": [\n            \"a\",\n            \"b\"\n        ]\n"
+				"    }", i ? ",\n" : "", i, next() % 10000, next() % 100,
+				next() % 100, next() % 2 ? "true" : "false");
+	}
+	put(b, "\n]");
+}
+
+/* Minified records shaped like a social media API response */
+static void gen_twitter(buffer *b, size_t size) {
+	static const char *words[] = {
+		"the", "release", "is", "out", "caf\xc3\xa9", "\\u2764", "today",
+		"\xe6\x97\xa5\xe6\x9c\xac", "@jsmn", "#json", "parser", "fast"
+	};
+	int i, j, n;
+
+	put(b, "{\"statuses\":[");
+	for (i = 0; b->len < size; i++) {
+		unsigned long id = 1000000000UL + next();
+		put(b, "%s{\"created_at\":\"Sun Aug 31 00:29:15 +0000 2014\","
+				"\"id\":%lu,\"id_str\":\"%lu\",\"text\":\"", i ? "," : "", id, id);
+		n = 4 + (int)(next() % 20);
+		for (j = 0; j < n; j++) {
+			put(b, "%s%s", j ? " " : "", words[next() % 12]);
+		}
+		put(b, "\",\"truncated\":false,\"entities\":{\"hashtags\":[");
+		n = (int)(next() % 3);
+		for (j = 0; j < n; j++) {
+			put(b, "%s{\"text\":\"tag%lu\",\"indices\":[%d,%d]}", j ? "," : "",
+					next() % 100, j * 10, j * 10 + 6);
+		}
+		put(b, "],\"urls\":[]},\"in_reply_to_status_id\":null,"
+				"\"user\":{\"id\":%lu,\"screen_name\":\"user%lu\","
+				"\"followers_count\":%lu,\"verified\":%s,\"lang\":\"en\"},"
+				"\"geo\":null,\"retweet_count\":%lu,\"favorited\":false,"
+				"\"lang\":\"en\"}", next(), next() % 100000, next() % 50000,
+				next() % 2 ? "true" : "false", next() % 1000);
+	}
+	put(b, "],\"search_metadata\":{\"count\":%d}}", i);
+}
+
+static double now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int cmp_double(const void *a, const void *b) {
+	double x = *(const double *)a, y = *(const double *)b;
+	return x < y ? -1 : x > y;
+}
+
+static int run(const char *name, void (*gen)(buffer *, size_t), size_t size) {
+	buffer b;
+	jsmntok_t *tokens;
+	jsmnuint_t num_tokens;
+	jsmn_parser parser;
+	jsmnint_t r = 0;
+	double rounds[ROUNDS], t;
+	size_t len;
+	int i, reps;
+
+	b.cap = size + 4096;
+	b.len = 0;
+	b.js = malloc(b.cap);
+	seed = 42;
+	gen(&b, size);
+	len = b.len;
+
+	num_tokens = (jsmnuint_t)(b.len / 2 + 16);
+	tokens = malloc(num_tokens * sizeof(jsmntok_t));
+
+	for (i = 0; i < ROUNDS; i++) {
+		double start = now_ns();
+		reps = 0;
+		do {
+			jsmn_init(&parser);
+			r = jsmn_parse(&parser, b.js, b.len, tokens, num_tokens);
+			reps++;
+			t = now_ns() - start;
+		} while (t < ROUND_NS);
+		rounds[i] = t / reps;
+	}
+	free(tokens);
+	free(b.js);
+	if (r <= 0) {
+		fprintf(stderr, "%s: parse error %d\n", name, (int)r);
+		return 1;
+	}
+	qsort(rounds, ROUNDS, sizeof(double), cmp_double);
+	t = rounds[ROUNDS / 2];
+
+	printf("%s\t%s\t%lu\t%ld\t%.1f\t%.0f\t%.2f\n", VARIANT, name,
+			(unsigned long)len, (long)r, len / t * 1e3, r / t * 1e9,
+			t / r);
+	fflush(stdout);
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	size_t size = 4 << 20;
+	int status = 0;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-H") == 0) {
+			printf("variant\tcorpus\tbytes\ttokens\tmb_per_s\ttokens_per_s\tns_per_token\n");
+		} else {
+			size = (size_t)atol(argv[i]);
+		}
+	}
+
+	status |= run("wide", gen_wide, size);
+	status |= run("deep", gen_deep, size);
+	status |= run("strings", gen_strings, size);
+	status |= run("numbers", gen_numbers, size);
+	status |= run("pretty", gen_pretty, size);
+	status |= run("twitter", gen_twitter, size);
+	return status;
+}
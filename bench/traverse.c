@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../jsmn.h"
+
+/*
+ * Traversal benchmark: parses a token-dense document once, then walks the
+ * whole token tree many times using only the token accessors, the way an
+ * application reading every value would. Built once with the default token
+ * layout and once with JSMN_PACKED (bench_traverse_packed) to compare them.
+ *
+ * Usage: bench_traverse [file.json]
+ * Without an argument, a 16 MiB synthetic document is used.
+ */
+
+#define PASSES 20
+
+static char *synthesize(size_t size, size_t *len) {
+	char *js = malloc(size + 256);
+	size_t n = 0;
+	int i = 0;
+
+	js[n++] = '[';
+	while (n < size) {
+		n += sprintf(js + n, "%s{\"a\":%d,\"b\":[%d,%d,true],\"c\":\"x\"}",
+				i ? "," : "", i % 10, i % 7, i % 3);
+		i++;
+	}
+	js[n++] = ']';
+	js[n] = '\0';
+	*len = n;
+	return js;
+}
+
+static char *load(const char *path, size_t *len) {
+	FILE *f = fopen(path, "rb");
+	char *js;
+	long size;
+
+	if (f == NULL) {
+		return NULL;
+	}
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	js = malloc(size + 1);
+	*len = fread(js, 1, size, f);
+	js[*len] = '\0';
+	fclose(f);
+	return js;
+}
+
+/*
+ * Visits a token and its children, adding up something from every string and
+ * primitive. Returns the number of tokens visited.
+ */
+static int walk(const char *js, jsmntok_t *t, unsigned long *sum) {
+	int i, n = 1;
+
+	if (jsmn_tok_type(t) == JSMN_STRING || jsmn_tok_type(t) == JSMN_PRIMITIVE) {
+		*sum += jsmn_tok_end(t) - jsmn_tok_start(t) + js[jsmn_tok_start(t)];
+	}
+	for (i = 0; i < jsmn_tok_size(t); i++) {
+		n += walk(js, t + n, sum);
+	}
+	return n;
+}
+
+int main(int argc, char *argv[]) {
+	jsmn_parser p;
+	jsmntok_t *tok;
+	unsigned long sum = 0;
+	size_t len;
+	clock_t start, parse, traverse;
+	char *js;
+	int i, r;
+
+	js = argc > 1 ? load(argv[1], &len) : synthesize((size_t)16 << 20, &len);
+	if (js == NULL) {
+		fprintf(stderr, "%s: cannot read\n", argv[1]);
+		return 1;
+	}
+	r = jsmn_validate(js, len);
+	if (r < 0) {
+		fprintf(stderr, "invalid JSON: %d\n", r);
+		return 1;
+	}
+	tok = malloc(sizeof(*tok) * r);
+
+	start = clock();
+	jsmn_init(&p);
+	r = jsmn_parse(&p, js, len, tok, r);
+	parse = clock() - start;
+
+	start = clock();
+	for (i = 0; i < PASSES; i++) {
+		walk(js, tok, &sum);
+	}
+	traverse = (clock() - start) / PASSES;
+
+	printf("%2u-byte tokens: %lu bytes of JSON, %d tokens (%lu bytes), "
+			"parse %.2f ms, traversal %.2f ms (%.2f ns/token) [%lu]\n",
+			(unsigned)sizeof(*tok), (unsigned long)len, r,
+			(unsigned long)(sizeof(*tok) * r),
+			1000.0 * parse / CLOCKS_PER_SEC,
+			1000.0 * traverse / CLOCKS_PER_SEC,
+			1e9 * traverse / CLOCKS_PER_SEC / r, sum);
+	free(tok);
+	free(js);
+	return 0;
+}
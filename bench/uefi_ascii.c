@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../Library/JsmnUefiLib/JsmnUefiLib.c"
+
+/*
+ * Boot-path benchmark for JsmnUefiLib, built on the host. A configuration
+ * blob is read as bytes, the way it comes out of a file or a variable, and
+ * parsed either by widening it into a pool-allocated CHAR16 copy for
+ * JsmnParser() or directly with JsmnParserAscii(). Built without and with
+ * JSMN_SIMD (bench_uefi_ascii_simd).
+ *
+ * It then reports the throughput of JsmnParser() over the CHAR16 documents
+ * whose token digests test_uefi compares: pretty-printed records, long
+ * strings with escapes and non-ASCII text, and a minified array of numbers.
+ *
+ * Usage: bench_uefi_ascii [entries]
+ */
+
+#define PASSES 200
+
+static CHAR8 *synthesize(int entries, UINTN *len) {
+	CHAR8 *js = malloc((size_t)entries * 300 + 64);
+	UINTN n = 0;
+	int i;
+
+	n += sprintf(js + n, "{\n  \"version\": 3,\n  \"entries\": [\n");
+	for (i = 0; i < entries; i++) {
+		n += sprintf(js + n, "    {\n      \"title\": \"Boot option %d\",\n"
+				"      \"path\": \"\\\\EFI\\\\vendor%d\\\\loader.efi\",\n"
+				"      \"timeout\": %d,\n      \"enabled\": %s\n    }%s\n",
+				i, i % 5, i * 3 % 30, i % 3 ? "true" : "false",
+				i + 1 < entries ? "," : "");
+	}
+	n += sprintf(js + n, "  ]\n}\n");
+	*len = n;
+	return js;
+}
+
+static UINT32 parse_widened(CONST CHAR8 *js, UINTN len, JSMNTOK_T *t, UINT32 numtok) {
+	CHAR16 *w = AllocatePool(len * sizeof(CHAR16));
+	JSMN_PARSER p;
+	UINTN i;
+	UINT32 r;
+
+	for (i = 0; i < len; i++) {
+		w[i] = (UINT8)js[i];
+	}
+	JsmnInit(&p);
+	r = JsmnParser(&p, w, len, t, numtok);
+	FreePool(w);
+	return r;
+}
+
+static UINT32 parse_ascii(CONST CHAR8 *js, UINTN len, JSMNTOK_T *t, UINT32 numtok) {
+	JSMN_PARSER p;
+
+	JsmnInit(&p);
+	return JsmnParserAscii(&p, js, len, t, numtok);
+}
+
+/* The documents of test_uefi_corpus */
+static CHAR16 *gen_doc(int kind, UINTN *len) {
+#ifdef JSMN_PACKED
+	UINTN cap = 0xF000, n = 0;
+#else
+	UINTN cap = 1 << 22, n = 0;
+#endif
+	CHAR16 *w = malloc(cap * sizeof(CHAR16));
+	char buf[256];
+	int i, j;
+
+#define PUT(s) do { const char *q_ = (s); while (*q_) w[n++] = (unsigned char)*q_++; } while (0)
+	PUT("[");
+	for (i = 0; n < cap - 4096; i++) {
+		if (i > 0) {
+			PUT(kind == 2 ? "," : ",\n");
+		}
+		switch (kind) {
+		case 0:
+			sprintf(buf, "    {\n        \"id\": %d,\n        \"name\": \"user%d\",\n"
+					"        \"tags\": [ \"a\", \"b\" ],\n        \"ok\": true\n    }", i, i);
+			PUT(buf);
+			break;
+		case 1:
+			PUT("  \"");
+			for (j = 0; j < 500 + i % 300; j++) {
+				if (j % 97 == 96) {
+					PUT("\\u00e9\\n");
+				} else {
+					w[n++] = (CHAR16)(j % 5 == 0 ? 0x4e2d + j % 7 : 'a' + j % 26);
+				}
+			}
+			PUT("\"");
+			break;
+		default:
+			sprintf(buf, "%d", i * 7919 % 100003);
+			PUT(buf);
+			break;
+		}
+	}
+	PUT("]");
+#undef PUT
+	w[n] = 0;
+	*len = n;
+	return w;
+}
+
+static int corpus(void) {
+	static const char *names[] = { "pretty", "strings", "numbers" };
+	UINT32 numtok = 1 << 22;
+	JSMNTOK_T *t = malloc(numtok * sizeof(JSMNTOK_T));
+	int kind, rep;
+
+	for (kind = 0; kind < 3; kind++) {
+		UINTN len;
+		CHAR16 *w = gen_doc(kind, &len);
+		INT32 r = 0;
+		double best = 1e9;
+
+		for (rep = 0; rep < 5; rep++) {
+			JSMN_PARSER p;
+			clock_t c0 = clock();
+			JsmnInit(&p);
+			r = (INT32)JsmnParser(&p, w, len, t, numtok);
+			c0 = clock() - c0;
+			if ((double)c0 / CLOCKS_PER_SEC < best) {
+				best = (double)c0 / CLOCKS_PER_SEC;
+			}
+		}
+		free(w);
+		if (r <= 0) {
+			fprintf(stderr, "%s: parse error %d\n", names[kind], (int)r);
+			free(t);
+			return 1;
+		}
+		printf("%-7s %9.1f MB/s\n", names[kind],
+				len * sizeof(CHAR16) / (best > 0 ? best : 1e-9) / 1e6);
+	}
+	free(t);
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	int entries = argc > 1 ? atoi(argv[1]) : 200;
+	UINTN len;
+	CHAR8 *js = synthesize(entries, &len);
+	UINT32 numtok = 12 * (UINT32)entries + 16;
+	JSMNTOK_T *t = malloc(numtok * sizeof(JSMNTOK_T));
+	clock_t start, widened, ascii;
+	INT32 a = 0, b = 0;
+	int pass;
+
+	start = clock();
+	for (pass = 0; pass < PASSES; pass++) {
+		a = (INT32)parse_widened(js, len, t, numtok);
+	}
+	widened = clock() - start;
+	start = clock();
+	for (pass = 0; pass < PASSES; pass++) {
+		b = (INT32)parse_ascii(js, len, t, numtok);
+	}
+	ascii = clock() - start;
+	if (a < 0 || a != b) {
+		fprintf(stderr, "results differ: %d %d\n", (int)a, (int)b);
+		return 1;
+	}
+
+	printf("%d entries, %lu bytes, %d tokens\n", entries, (unsigned long)len, (int)a);
+	printf("widened %9.2f us/parse\n", 1e6 * widened / CLOCKS_PER_SEC / PASSES);
+	printf("ascii   %9.2f us/parse\n", 1e6 * ascii / CLOCKS_PER_SEC / PASSES);
+	free(t);
+	free(js);
+	return corpus();
+}
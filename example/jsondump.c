@@ -4,6 +4,7 @@
 #include <string.h>
 #include <errno.h>
 #include "../jsmn.h"
+#include "../jsmn_file.h"
 
 /* Function realloc_it() is a wrapper function for standart realloc()
  * with one difference - it frees old memory pointer in case of realloc
@@ -20,9 +21,16 @@ static inline void *realloc_it(void *ptrmem, size_t size) {
 	return p;
 }
 
+/* Token allocator for jsmn_parse_grow() */
+static void *realloc_tokens(void *ptr, size_t size, void *data) {
+	(void)data;
+	return realloc(ptr, size);
+}
+
 /*
  * An example of reading JSON from stdin and printing its content to stdout.
  * The output looks like YAML, but I'm not sure if it's really compatible.
+ * With a file name argument, the file is mapped and parsed in place instead.
  */
 
 static int dump(const char *js, jsmntok_t *t, size_t count, int indent) {
@@ -30,16 +38,16 @@ static int dump(const char *js, jsmntok_t *t, size_t count, int indent) {
 	if (count == 0) {
 		return 0;
 	}
-	if (t->type == JSMN_PRIMITIVE) {
-		printf("%.*s", t->end - t->start, js+t->start);
+	if (jsmn_tok_type(t) == JSMN_PRIMITIVE) {
+		printf("%.*s", (int)(jsmn_tok_end(t) - jsmn_tok_start(t)), js+jsmn_tok_start(t));
 		return 1;
-	} else if (t->type == JSMN_STRING) {
-		printf("'%.*s'", t->end - t->start, js+t->start);
+	} else if (jsmn_tok_type(t) == JSMN_STRING) {
+		printf("'%.*s'", (int)(jsmn_tok_end(t) - jsmn_tok_start(t)), js+jsmn_tok_start(t));
 		return 1;
-	} else if (t->type == JSMN_OBJECT) {
+	} else if (jsmn_tok_type(t) == JSMN_OBJECT) {
 		printf("\n");
 		j = 0;
-		for (i = 0; i < t->size; i++) {
+		for (i = 0; i < jsmn_tok_size(t); i++) {
 			for (k = 0; k < indent; k++) printf("  ");
 			j += dump(js, t+1+j, count-j, indent+1);
 			printf(": ");
@@ -47,10 +55,10 @@ static int dump(const char *js, jsmntok_t *t, size_t count, int indent) {
 			printf("\n");
 		}
 		return j+1;
-	} else if (t->type == JSMN_ARRAY) {
+	} else if (jsmn_tok_type(t) == JSMN_ARRAY) {
 		j = 0;
 		printf("\n");
-		for (i = 0; i < t->size; i++) {
+		for (i = 0; i < jsmn_tok_size(t); i++) {
 			for (k = 0; k < indent-1; k++) printf("  ");
 			printf("   - ");
 			j += dump(js, t+1+j, count-j, indent+1);
@@ -61,7 +69,35 @@ static int dump(const char *js, jsmntok_t *t, size_t count, int indent) {
 	return 0;
 }
 
-int main() {
+/*
+ * Parses the mapped file without copying it: tokens point into the mapping.
+ */
+static int dump_file(const char *path) {
+	const char *js;
+	size_t jslen;
+	jsmn_parser p;
+	jsmntok_t *tok = NULL;
+	jsmnuint_t tokcount = 0;
+	int r;
+
+	jsmn_init(&p);
+	r = jsmn_parse_file(&p, path, &js, &jslen, &tok, &tokcount,
+			realloc_tokens, NULL);
+	if (r == JSMN_ERROR_FILE) {
+		fprintf(stderr, "%s: errno=%d\n", path, errno);
+		return 1;
+	}
+	if (r < 0) {
+		fprintf(stderr, "jsmn_parse_file(): %d\n", r);
+	} else {
+		dump(js, tok, p.toknext, 0);
+	}
+	jsmn_unmap_file(js, jslen);
+	free(tok);
+	return r < 0 ? 2 : 0;
+}
+
+int main(int argc, char *argv[]) {
 	int r;
 	int eof_expected = 0;
 	char *js = NULL;
@@ -69,19 +105,16 @@ int main() {
 	char buf[BUFSIZ];
 
 	jsmn_parser p;
-	jsmntok_t *tok;
-	size_t tokcount = 2;
+	jsmntok_t *tok = NULL;
+	jsmnuint_t tokcount = 0;
+
+	if (argc > 1) {
+		return dump_file(argv[1]);
+	}
 
 	/* Prepare parser */
 	jsmn_init(&p);
 
-	/* Allocate some tokens as a start */
-	tok = malloc(sizeof(*tok) * tokcount);
-	if (tok == NULL) {
-		fprintf(stderr, "malloc(): errno=%d\n", errno);
-		return 3;
-	}
-
 	for (;;) {
 		/* Read another chunk */
 		r = fread(buf, 1, sizeof(buf), stdin);
@@ -105,16 +138,12 @@ int main() {
 		strncpy(js + jslen, buf, r);
 		jslen = jslen + r;
 
-again:
-		r = jsmn_parse(&p, js, jslen, tok, tokcount);
+		/* Tokens are allocated as the parser needs them */
+		r = jsmn_parse_grow(&p, js, jslen, &tok, &tokcount, realloc_tokens, NULL);
 		if (r < 0) {
 			if (r == JSMN_ERROR_NOMEM) {
-				tokcount = tokcount * 2;
-				tok = realloc_it(tok, sizeof(*tok) * tokcount);
-				if (tok == NULL) {
-					return 3;
-				}
-				goto again;
+				fprintf(stderr, "realloc(): errno=%d\n", errno);
+				return 3;
 			}
 		} else {
 			dump(js, tok, p.toknext, 0);
@@ -13,18 +13,28 @@ static const char *JSON_STRING =
 	"\"groups\": [\"users\", \"wheel\", \"audio\", \"video\"]}";
 
 static int jsoneq(const char *json, jsmntok_t *tok, const char *s) {
-	if (tok->type == JSMN_STRING && (int) strlen(s) == tok->end - tok->start &&
-			strncmp(json + tok->start, s, tok->end - tok->start) == 0) {
+	if (jsmn_tok_type(tok) == JSMN_STRING &&
+			(int) strlen(s) == jsmn_tok_end(tok) - jsmn_tok_start(tok) &&
+			strncmp(json + jsmn_tok_start(tok), s,
+				jsmn_tok_end(tok) - jsmn_tok_start(tok)) == 0) {
 		return 0;
 	}
 	return -1;
 }
 
+static void print_value(const char *name, jsmntok_t *tok) {
+	printf("- %s: %.*s\n", name, (int)(jsmn_tok_end(tok) - jsmn_tok_start(tok)),
+			JSON_STRING + jsmn_tok_start(tok));
+}
+
 int main() {
 	int i;
 	int r;
 	jsmn_parser p;
 	jsmntok_t t[128]; /* We expect no more than 128 tokens */
+	jsmnslot_t slots[16];
+	jsmnkeyindex_t index;
+	jsmncursor_t cursor;
 
 	jsmn_init(&p);
 	r = jsmn_parse(&p, JSON_STRING, strlen(JSON_STRING), t, sizeof(t)/sizeof(t[0]));
@@ -34,42 +44,56 @@ int main() {
 	}
 
 	/* Assume the top-level element is an object */
-	if (r < 1 || t[0].type != JSMN_OBJECT) {
+	if (r < 1 || jsmn_tok_type(&t[0]) != JSMN_OBJECT) {
 		printf("Object expected\n");
 		return 1;
 	}
 
-	/* Loop over all keys of the root object */
-	for (i = 1; i < r; i++) {
-		if (jsoneq(JSON_STRING, &t[i], "user") == 0) {
-			/* We may use strndup() to fetch string value */
-			printf("- User: %.*s\n", t[i+1].end-t[i+1].start,
-					JSON_STRING + t[i+1].start);
-			i++;
-		} else if (jsoneq(JSON_STRING, &t[i], "admin") == 0) {
-			/* We may additionally check if the value is either "true" or "false" */
-			printf("- Admin: %.*s\n", t[i+1].end-t[i+1].start,
-					JSON_STRING + t[i+1].start);
-			i++;
-		} else if (jsoneq(JSON_STRING, &t[i], "uid") == 0) {
-			/* We may want to do strtol() here to get numeric value */
-			printf("- UID: %.*s\n", t[i+1].end-t[i+1].start,
-					JSON_STRING + t[i+1].start);
-			i++;
-		} else if (jsoneq(JSON_STRING, &t[i], "groups") == 0) {
-			int j;
-			printf("- Groups:\n");
-			if (t[i+1].type != JSMN_ARRAY) {
-				continue; /* We expect groups to be an array of strings */
-			}
-			for (j = 0; j < t[i+1].size; j++) {
-				jsmntok_t *g = &t[i+j+2];
-				printf("  * %.*s\n", g->end - g->start, JSON_STRING + g->start);
+	/* Index the keys of all objects, then look them up in O(1) */
+	index.slots = slots;
+	index.size = jsmn_key_index_size(t, r);
+	if (index.size > sizeof(slots)/sizeof(slots[0]) ||
+			jsmn_build_key_index(&index, JSON_STRING, t, r) < 0) {
+		printf("Too many keys\n");
+		return 1;
+	}
+
+	if ((i = jsmn_lookup(&index, JSON_STRING, t, 0, "user")) >= 0) {
+		/* We may use strndup() to fetch string value */
+		print_value("User", &t[i]);
+	}
+	if ((i = jsmn_lookup(&index, JSON_STRING, t, 0, "admin")) >= 0) {
+		/* We may additionally check if the value is either "true" or "false" */
+		print_value("Admin", &t[i]);
+	}
+	if ((i = jsmn_lookup(&index, JSON_STRING, t, 0, "uid")) >= 0) {
+		/* We may want to do strtol() here to get numeric value */
+		print_value("UID", &t[i]);
+	}
+	if ((i = jsmn_lookup(&index, JSON_STRING, t, 0, "groups")) >= 0) {
+		int j;
+		printf("- Groups:\n");
+		/* We expect groups to be an array of strings */
+		if (jsmn_tok_type(&t[i]) == JSMN_ARRAY) {
+			for (j = 0; j < jsmn_tok_size(&t[i]); j++) {
+				jsmntok_t *g = &t[i+j+1];
+				printf("  * %.*s\n", (int)(jsmn_tok_end(g) - jsmn_tok_start(g)),
+						JSON_STRING + jsmn_tok_start(g));
 			}
-			i += t[i+1].size + 1;
-		} else {
-			printf("Unexpected key: %.*s\n", t[i].end-t[i].start,
-					JSON_STRING + t[i].start);
+		}
+	}
+
+	/* Loop over all keys of the root object for the ones not handled above */
+	jsmn_cursor_init(&cursor, t, r);
+	for (i = jsmn_cursor_first_child(&cursor); i >= 0;
+			i = jsmn_cursor_next_sibling(&cursor)) {
+		if (jsoneq(JSON_STRING, &t[i], "user") != 0 &&
+				jsoneq(JSON_STRING, &t[i], "admin") != 0 &&
+				jsoneq(JSON_STRING, &t[i], "uid") != 0 &&
+				jsoneq(JSON_STRING, &t[i], "groups") != 0) {
+			printf("Unexpected key: %.*s\n",
+					(int)(jsmn_tok_end(&t[i]) - jsmn_tok_start(&t[i])),
+					JSON_STRING + jsmn_tok_start(&t[i]));
 		}
 	}
 	return EXIT_SUCCESS;
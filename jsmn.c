@@ -1,307 +1,1737 @@
 #include "jsmn.h"
 
+#ifdef JSMN_SIMD
+#include <stdint.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define JSMN_SSE2
+#endif
+#if defined(JSMN_UTF8) && defined(__SSSE3__) && !defined(__AVX2__)
+#include <tmmintrin.h>
+#endif
+
 /**
- * Allocates a fresh unused token from the token pull.
+ * Whitespace map of one 64-byte block of input. Bit i of the mask is set
+ * when js[base + i] is not JSON whitespace. It only lets the parser skip runs
+ * of whitespace; the byte it stops on is classified as usual. Positions past
+ * the end of input are set as well, so a lookup always stops at `len`.
  */
-static jsmntok_t *jsmn_alloc_token(jsmn_parser *parser,
-		jsmntok_t *tokens, size_t num_tokens) {
-	jsmntok_t *tok;
-	if (parser->toknext >= num_tokens) {
-		return NULL;
+typedef struct {
+	size_t base;
+	size_t end;
+	uint64_t mask;
+} jsmn_space_map;
+
+#if defined(__GNUC__)
+#define jsmn_ctz64(x) ((unsigned int)__builtin_ctzll(x))
+#else
+static unsigned int jsmn_ctz64(uint64_t x) {
+	unsigned int n = 0;
+	while (!(x & 1)) {
+		x >>= 1;
+		n++;
 	}
-	tok = &tokens[parser->toknext++];
-	tok->start = tok->end = -1;
-	tok->size = 0;
-#ifdef JSMN_PARENT_LINKS
-	tok->parent = -1;
-#endif
-	return tok;
+	return n;
 }
+#endif
+
+#define jsmn_is_space(c) ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
 
 /**
- * Fills token type and boundaries.
+ * Builds the whitespace bitmap for the 64 bytes at p.
  */
-static void jsmn_fill_token(jsmntok_t *token, jsmntype_t type,
-                            int start, int end) {
-	token->type = type;
-	token->start = start;
-	token->end = end;
-	token->size = 0;
+static uint64_t jsmn_whitespace_block(const char *p) {
+	uint64_t ws = 0;
+	int i;
+#if defined(__AVX2__)
+	const __m256i sp = _mm256_set1_epi8(' ');
+	const __m256i tab = _mm256_set1_epi8('\t');
+	const __m256i nl = _mm256_set1_epi8('\n');
+	const __m256i cr = _mm256_set1_epi8('\r');
+	for (i = 0; i < 64; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+		__m256i m = _mm256_or_si256(
+				_mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, tab)),
+				_mm256_or_si256(_mm256_cmpeq_epi8(v, nl), _mm256_cmpeq_epi8(v, cr)));
+		ws |= (uint64_t)(uint32_t)_mm256_movemask_epi8(m) << i;
+	}
+#elif defined(JSMN_SSE2)
+	const __m128i sp = _mm_set1_epi8(' ');
+	const __m128i tab = _mm_set1_epi8('\t');
+	const __m128i nl = _mm_set1_epi8('\n');
+	const __m128i cr = _mm_set1_epi8('\r');
+	for (i = 0; i < 64; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+		__m128i m = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, tab)),
+				_mm_or_si128(_mm_cmpeq_epi8(v, nl), _mm_cmpeq_epi8(v, cr)));
+		ws |= (uint64_t)(uint16_t)_mm_movemask_epi8(m) << i;
+	}
+#else
+	/* Scalar fallback */
+	for (i = 0; i < 64; i++) {
+		if (jsmn_is_space(p[i])) {
+			ws |= (uint64_t)1 << i;
+		}
+	}
+#endif
+	return ws;
 }
 
 /**
- * Fills next available token with JSON primitive.
+ * Returns the position of the first quote, backslash or control byte at or
+ * after pos, or len if there is none. Everything in between is plain string
+ * body and needs no further inspection.
  */
-static int jsmn_parse_primitive(jsmn_parser *parser, const char *js,
-		size_t len, jsmntok_t *tokens, size_t num_tokens) {
-	jsmntok_t *token;
-	int start;
+static size_t jsmn_scan_string(const char *js, size_t len, size_t pos) {
+#if defined(__AVX2__)
+	const __m256i quote = _mm256_set1_epi8('\"');
+	const __m256i bslash = _mm256_set1_epi8('\\');
+	const __m256i ctl = _mm256_set1_epi8(0x1f);
+	const __m256i zero = _mm256_setzero_si256();
+	for (; pos + 32 <= len; pos += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(js + pos));
+		__m256i m = _mm256_or_si256(
+				_mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, bslash)),
+				_mm256_cmpeq_epi8(_mm256_subs_epu8(v, ctl), zero));
+		uint32_t bits = (uint32_t)_mm256_movemask_epi8(m);
+		if (bits != 0) {
+			return pos + jsmn_ctz64(bits);
+		}
+	}
+#elif defined(JSMN_SSE2)
+	const __m128i quote = _mm_set1_epi8('\"');
+	const __m128i bslash = _mm_set1_epi8('\\');
+	const __m128i ctl = _mm_set1_epi8(0x1f);
+	const __m128i zero = _mm_setzero_si128();
+	for (; pos + 16 <= len; pos += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(js + pos));
+		__m128i m = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, bslash)),
+				_mm_cmpeq_epi8(_mm_subs_epu8(v, ctl), zero));
+		uint32_t bits = (uint32_t)_mm_movemask_epi8(m);
+		if (bits != 0) {
+			return pos + jsmn_ctz64(bits);
+		}
+	}
+#endif
+	for (; pos < len; pos++) {
+		unsigned char c = (unsigned char)js[pos];
+		if (c == '\"' || c == '\\' || c < 0x20) {
+			return pos;
+		}
+	}
+	return len;
+}
 
-	start = parser->pos;
+/**
+ * (Re)builds the map for the block containing pos.
+ */
+static void jsmn_map_block(jsmn_space_map *map, const char *js, size_t len,
+		size_t pos) {
+	size_t i;
+	map->base = pos & ~(size_t)63;
+	map->end = map->base + 64;
+	if (map->end <= len) {
+		map->mask = ~jsmn_whitespace_block(js + map->base);
+		return;
+	}
+	/* Tail block: classify what is left and mark the rest as a stop */
+	map->mask = ~(uint64_t)0;
+	for (i = map->base; i < len; i++) {
+		if (jsmn_is_space(js[i])) {
+			map->mask &= ~((uint64_t)1 << (i - map->base));
+		}
+	}
+}
 
-	for (; parser->pos < len && js[parser->pos] != '\0'; parser->pos++) {
-		switch (js[parser->pos]) {
-#ifndef JSMN_STRICT
-			/* In strict mode primitive must be followed by "," or "}" or "]" */
-			case ':':
-#endif
-			case '\t' : case '\r' : case '\n' : case ' ' :
-			case ','  : case ']'  : case '}' :
-				goto found;
+/**
+ * Returns the position of the first non-whitespace byte at or after pos,
+ * or len if there is none.
+ */
+static size_t jsmn_skip_whitespace(jsmn_space_map *map, const char *js,
+		size_t len, size_t pos) {
+	while (pos < len) {
+		uint64_t m;
+		if (pos < map->base || pos >= map->end) {
+			jsmn_map_block(map, js, len, pos);
 		}
-		if (js[parser->pos] < 32 || js[parser->pos] >= 127) {
-			parser->pos = start;
-			return JSMN_ERROR_INVAL;
+		m = map->mask >> (pos - map->base);
+		if (m != 0) {
+			return pos + jsmn_ctz64(m);
 		}
+		pos = map->end;
 	}
-#ifdef JSMN_STRICT
-	/* In strict mode primitive must be followed by a comma/object/array */
-	parser->pos = start;
-	return JSMN_ERROR_PART;
+	return len;
+}
+#endif /* JSMN_SIMD */
+
+#ifdef JSMN_PACKED
+/* Bit 3 of a packed token's info: key with a value, or container still open */
+#define JSMN_FLAG 8
 #endif
 
-found:
-	if (tokens == NULL) {
-		parser->pos--;
+#ifdef JSMN_SPANS
+#define jsmn_tok_set_span(t, n) ((t)->span = (n))
+#else
+#define jsmn_tok_set_span(t, n) ((void)0)
+#endif
+
+/*
+ * Token updates, for plain and linked tokens alike. Objects and arrays are
+ * filled with end -1 until they are closed.
+ */
+#ifdef JSMN_PACKED
+#define jsmn_tok_reset(t) ((t)->start = (unsigned int)-1, (t)->info = 0)
+#define jsmn_tok_fill(t, type_, s, e) ((t)->start = (s), \
+		(t)->info = (type_) >= JSMN_STRING ? \
+		(unsigned int)((e) - (s)) << 4 | (type_) : JSMN_FLAG | (type_), \
+		jsmn_tok_set_span(t, (type_) >= JSMN_STRING))
+#define jsmn_tok_add_child(t) (jsmn_tok_type(t) >= JSMN_STRING ? \
+		((t)->info |= JSMN_FLAG) : ((t)->info += 1 << 4))
+#define jsmn_tok_close(t, e, n) ((t)->info &= ~JSMN_FLAG, jsmn_tok_set_span(t, n))
+#define jsmn_tok_is_open(t) \
+		(jsmn_tok_type(t) < JSMN_STRING && ((t)->info & JSMN_FLAG))
+#else
+#define jsmn_tok_reset(t) ((t)->start = (t)->end = -1, (t)->size = 0)
+#define jsmn_tok_fill(t, type_, s, e) ((t)->type = (type_), (t)->start = (s), \
+		(t)->end = (e), (t)->size = 0, \
+		jsmn_tok_set_span(t, (type_) >= JSMN_STRING))
+#define jsmn_tok_add_child(t) ((t)->size++)
+#define jsmn_tok_close(t, e, n) ((t)->end = (e), jsmn_tok_set_span(t, n))
+#define jsmn_tok_is_open(t) ((t)->start != -1 && (t)->end == -1)
+#endif
+
+#ifdef JSMN_UTF8
+/**
+ * Length of the UTF-8 sequence at p, of which n bytes are there, or 0 if it
+ * is malformed (Unicode, table 3-7: no overlong forms, surrogates or code
+ * points past U+10FFFF), or -1 if the end of input cuts it short.
+ */
+static int jsmn_utf8_char(const unsigned char *p, size_t n) {
+	unsigned char lo, hi;
+	size_t j, k;
+
+	if (p[0] < 0xC2 || p[0] > 0xF4) {
 		return 0;
 	}
-	token = jsmn_alloc_token(parser, tokens, num_tokens);
-	if (token == NULL) {
-		parser->pos = start;
-		return JSMN_ERROR_NOMEM;
+	k = p[0] < 0xE0 ? 2 : p[0] < 0xF0 ? 3 : 4;
+	/* The second byte of some leads has a narrower range */
+	lo = p[0] == 0xE0 ? 0xA0 : p[0] == 0xF0 ? 0x90 : 0x80;
+	hi = p[0] == 0xED ? 0x9F : p[0] == 0xF4 ? 0x8F : 0xBF;
+	for (j = 1; j < k; j++) {
+		if (j >= n) {
+			return -1;
+		}
+		if (p[j] < lo || p[j] > hi) {
+			return 0;
+		}
+		lo = 0x80;
+		hi = 0xBF;
 	}
-	jsmn_fill_token(token, JSMN_PRIMITIVE, start, parser->pos);
-#ifdef JSMN_PARENT_LINKS
-	token->parent = parser->toksuper;
-#endif
-	parser->pos--;
-	return 0;
+	return (int)k;
 }
 
+#if defined(JSMN_SIMD) && (defined(__AVX2__) || defined(JSMN_SSE2))
+#define JSMN_UTF8_VECTOR
+
 /**
- * Fills next token with JSON string.
+ * Bit i is set when byte i of in is a quote, a backslash or a control byte.
  */
-static int jsmn_parse_string(jsmn_parser *parser, const char *js,
-		size_t len, jsmntok_t *tokens, size_t num_tokens) {
-	jsmntok_t *token;
+static unsigned int jsmn_stop_mask(__m128i in) {
+	return (unsigned int)_mm_movemask_epi8(_mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(in, _mm_set1_epi8('\"')),
+					_mm_cmpeq_epi8(in, _mm_set1_epi8('\\'))),
+				_mm_cmpeq_epi8(_mm_subs_epu8(in, _mm_set1_epi8(0x1f)),
+					_mm_setzero_si128())));
+}
+#endif
 
-	int start = parser->pos;
+#if defined(JSMN_UTF8_VECTOR) && defined(__SSSE3__)
+/*
+ * Error classes of the lookup algorithm of Keiser and Lemire ("Validating
+ * UTF-8 in less than one instruction per byte", 2021). Each byte pair is
+ * looked up by the high and low nibble of its first byte and the high
+ * nibble of its second; the classes all three agree on are errors.
+ */
+#define JSMN_UTF8_TOO_SHORT 0x01 /* lead not followed by a continuation */
+#define JSMN_UTF8_TOO_LONG 0x02 /* continuation after ASCII */
+#define JSMN_UTF8_OVERLONG_3 0x04 /* E0 80..9F */
+#define JSMN_UTF8_TOO_LARGE 0x08 /* F4 90..BF, F5..FF */
+#define JSMN_UTF8_SURROGATE 0x10 /* ED A0..BF */
+#define JSMN_UTF8_OVERLONG_2 0x20 /* C0, C1 */
+#define JSMN_UTF8_TOO_LARGE_1000 0x40 /* F5..FF 80..8F */
+#define JSMN_UTF8_OVERLONG_4 0x40 /* F0 80..8F */
+#define JSMN_UTF8_TWO_CONTS 0x80 /* continuation after continuation */
+#define JSMN_UTF8_CARRY (JSMN_UTF8_TOO_SHORT | JSMN_UTF8_TOO_LONG | \
+		JSMN_UTF8_TWO_CONTS)
 
-	parser->pos++;
+/**
+ * Error bits of the 16 bytes in, given the 16 bytes before them. A third or
+ * fourth byte of a sequence shows as a continuation flagged TWO_CONTS that
+ * is expected, so those cancel out.
+ */
+static __m128i jsmn_utf8_block(__m128i in, __m128i prev) {
+	const __m128i nibble = _mm_set1_epi8(0x0F);
+	const __m128i byte_1_high = _mm_setr_epi8(
+			JSMN_UTF8_TOO_LONG, JSMN_UTF8_TOO_LONG, JSMN_UTF8_TOO_LONG,
+			JSMN_UTF8_TOO_LONG, JSMN_UTF8_TOO_LONG, JSMN_UTF8_TOO_LONG,
+			JSMN_UTF8_TOO_LONG, JSMN_UTF8_TOO_LONG,
+			(char)JSMN_UTF8_TWO_CONTS, (char)JSMN_UTF8_TWO_CONTS,
+			(char)JSMN_UTF8_TWO_CONTS, (char)JSMN_UTF8_TWO_CONTS,
+			JSMN_UTF8_TOO_SHORT | JSMN_UTF8_OVERLONG_2,
+			JSMN_UTF8_TOO_SHORT,
+			JSMN_UTF8_TOO_SHORT | JSMN_UTF8_OVERLONG_3 | JSMN_UTF8_SURROGATE,
+			JSMN_UTF8_TOO_SHORT | JSMN_UTF8_TOO_LARGE |
+			JSMN_UTF8_TOO_LARGE_1000 | JSMN_UTF8_OVERLONG_4);
+	const __m128i byte_1_low = _mm_setr_epi8(
+			(char)(JSMN_UTF8_CARRY | JSMN_UTF8_OVERLONG_3 |
+				JSMN_UTF8_OVERLONG_2 | JSMN_UTF8_OVERLONG_4),
+			(char)(JSMN_UTF8_CARRY | JSMN_UTF8_OVERLONG_2),
+			(char)JSMN_UTF8_CARRY, (char)JSMN_UTF8_CARRY,
+			(char)(JSMN_UTF8_CARRY | JSMN_UTF8_TOO_LARGE),
+			(char)(JSMN_UTF8_CARRY | JSMN_UTF8_TOO_LARGE |
+				JSMN_UTF8_TOO_LARGE_1000),
+			(char)(JSMN_UTF8_CARRY | JSMN_UTF8_TOO_LARGE |
+				JSMN_UTF8_TOO_LARGE_1000),
+			(char)(JSMN_UTF8_CARRY | JSMN_UTF8_TOO_LARGE |
+				JSMN_UTF8_TOO_LARGE_1000),
+			(char)(JSMN_UTF8_CARRY | JSMN_UTF8_TOO_LARGE |
+				JSMN_UTF8_TOO_LARGE_1000),
+			(char)(JSMN_UTF8_CARRY | JSMN_UTF8_TOO_LARGE |
+				JSMN_UTF8_TOO_LARGE_1000),
+			(char)(JSMN_UTF8_CARRY | JSMN_UTF8_TOO_LARGE |
+				JSMN_UTF8_TOO_LARGE_1000),
+			(char)(JSMN_UTF8_CARRY | JSMN_UTF8_TOO_LARGE |
+				JSMN_UTF8_TOO_LARGE_1000),
+			(char)(JSMN_UTF8_CARRY | JSMN_UTF8_TOO_LARGE |
+				JSMN_UTF8_TOO_LARGE_1000),
+			(char)(JSMN_UTF8_CARRY | JSMN_UTF8_TOO_LARGE |
+				JSMN_UTF8_TOO_LARGE_1000 | JSMN_UTF8_SURROGATE),
+			(char)(JSMN_UTF8_CARRY | JSMN_UTF8_TOO_LARGE |
+				JSMN_UTF8_TOO_LARGE_1000),
+			(char)(JSMN_UTF8_CARRY | JSMN_UTF8_TOO_LARGE |
+				JSMN_UTF8_TOO_LARGE_1000));
+	const __m128i byte_2_high = _mm_setr_epi8(
+			JSMN_UTF8_TOO_SHORT, JSMN_UTF8_TOO_SHORT, JSMN_UTF8_TOO_SHORT,
+			JSMN_UTF8_TOO_SHORT, JSMN_UTF8_TOO_SHORT, JSMN_UTF8_TOO_SHORT,
+			JSMN_UTF8_TOO_SHORT, JSMN_UTF8_TOO_SHORT,
+			(char)(JSMN_UTF8_TOO_LONG | JSMN_UTF8_OVERLONG_2 |
+				JSMN_UTF8_TWO_CONTS | JSMN_UTF8_OVERLONG_3 |
+				JSMN_UTF8_TOO_LARGE_1000 | JSMN_UTF8_OVERLONG_4),
+			(char)(JSMN_UTF8_TOO_LONG | JSMN_UTF8_OVERLONG_2 |
+				JSMN_UTF8_TWO_CONTS | JSMN_UTF8_OVERLONG_3 |
+				JSMN_UTF8_TOO_LARGE),
+			(char)(JSMN_UTF8_TOO_LONG | JSMN_UTF8_OVERLONG_2 |
+				JSMN_UTF8_TWO_CONTS | JSMN_UTF8_SURROGATE |
+				JSMN_UTF8_TOO_LARGE),
+			(char)(JSMN_UTF8_TOO_LONG | JSMN_UTF8_OVERLONG_2 |
+				JSMN_UTF8_TWO_CONTS | JSMN_UTF8_SURROGATE |
+				JSMN_UTF8_TOO_LARGE),
+			JSMN_UTF8_TOO_SHORT, JSMN_UTF8_TOO_SHORT, JSMN_UTF8_TOO_SHORT,
+			JSMN_UTF8_TOO_SHORT);
+	__m128i prev1 = _mm_alignr_epi8(in, prev, 15);
+	__m128i special = _mm_and_si128(_mm_and_si128(
+				_mm_shuffle_epi8(byte_1_high,
+					_mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+				_mm_shuffle_epi8(byte_1_low, _mm_and_si128(prev1, nibble))),
+			_mm_shuffle_epi8(byte_2_high,
+				_mm_and_si128(_mm_srli_epi16(in, 4), nibble)));
+	/* Bytes two after an E0..FF lead or three after an F0..FF lead */
+	__m128i must23 = _mm_and_si128(_mm_or_si128(
+				_mm_subs_epu8(_mm_alignr_epi8(in, prev, 14),
+					_mm_set1_epi8((char)(0xE0 - 0x80))),
+				_mm_subs_epu8(_mm_alignr_epi8(in, prev, 13),
+					_mm_set1_epi8((char)(0xF0 - 0x80)))),
+			_mm_set1_epi8((char)0x80));
+	return _mm_xor_si128(must23, special);
+}
+#endif
 
-	/* Skip starting quote */
-	for (; parser->pos < len && js[parser->pos] != '\0'; parser->pos++) {
-		char c = js[parser->pos];
+/**
+ * jsmn_scan_string() checking UTF-8: moves *at to the first quote, backslash
+ * or control byte at or after it, or to len, and checks the text skipped.
+ * Each block of 16 bytes is loaded once; the ones with non-ASCII bytes are
+ * run through jsmn_utf8_block() in SSSE3 builds, and through
+ * jsmn_utf8_char() for each sequence in other JSMN_SIMD builds. Returns 0,
+ * JSMN_ERROR_UTF8, or JSMN_ERROR_PART with *at on the lead byte of a
+ * sequence cut by the end of input.
+ */
+static int jsmn_scan_utf8(const char *js, size_t len, size_t *at) {
+	size_t pos = *at;
+	unsigned char c;
+	int n;
+#ifdef JSMN_UTF8_VECTOR
+	__m128i in;
+	unsigned int stops;
+#ifdef __SSSE3__
+	const __m128i zero = _mm_setzero_si128();
+	/* Lead bytes that need more bytes than are left in the block */
+	const __m128i cut = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			-1, -1, -1, (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+	__m128i prev = zero;
+	unsigned int errors, open = 0;
 
-		/* Quote: end of string */
-		if (c == '\"') {
-			if (tokens == NULL) {
-				return 0;
+	for (; pos + 16 <= len; pos += 16) {
+		in = _mm_loadu_si128((const __m128i *)(js + pos));
+		stops = jsmn_stop_mask(in);
+		if (_mm_movemask_epi8(in) != 0 || open) {
+			errors = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(
+						jsmn_utf8_block(in, prev), zero)) ^ 0xFFFF;
+			/* A sequence cut by a stop shows as an error at the latest there */
+			if (stops != 0) {
+				errors &= (2u << jsmn_ctz64(stops)) - 1;
 			}
-			token = jsmn_alloc_token(parser, tokens, num_tokens);
-			if (token == NULL) {
-				parser->pos = start;
-				return JSMN_ERROR_NOMEM;
+			if (errors != 0) {
+				*at = pos;
+				return JSMN_ERROR_UTF8;
 			}
-			jsmn_fill_token(token, JSMN_STRING, start+1, parser->pos);
-#ifdef JSMN_PARENT_LINKS
-			token->parent = parser->toksuper;
-#endif
+			open = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(
+						_mm_subs_epu8(in, cut), zero)) ^ 0xFFFF;
+		}
+		if (stops != 0) {
+			*at = pos + jsmn_ctz64(stops);
 			return 0;
 		}
+		prev = in;
+	}
+	/* Go on from the lead of a sequence the last block cut */
+	if (open != 0) {
+		pos -= 16 - jsmn_ctz64(open);
+	}
+#else
+	unsigned int high, k;
+	size_t done = pos; /* end of the last sequence checked */
 
-		/* Backslash: Quoted symbol expected */
-		if (c == '\\' && parser->pos + 1 < len) {
-			int i;
-			parser->pos++;
-			switch (js[parser->pos]) {
-				/* Allowed escaped symbols */
-				case '\"': case '/' : case '\\' : case 'b' :
-				case 'f' : case 'r' : case 'n'  : case 't' :
-					break;
-				/* Allows escaped symbol \uXXXX */
-				case 'u':
-					parser->pos++;
-					for(i = 0; i < 4 && parser->pos < len && js[parser->pos] != '\0'; i++) {
-						/* If it isn't a hex character we have an error */
-						if(!((js[parser->pos] >= 48 && js[parser->pos] <= 57) || /* 0-9 */
-									(js[parser->pos] >= 65 && js[parser->pos] <= 70) || /* A-F */
-									(js[parser->pos] >= 97 && js[parser->pos] <= 102))) { /* a-f */
-							parser->pos = start;
-							return JSMN_ERROR_INVAL;
-						}
-						parser->pos++;
-					}
-					parser->pos--;
-					break;
-				/* Unexpected symbol */
-				default:
-					parser->pos = start;
-					return JSMN_ERROR_INVAL;
+	for (; pos + 16 <= len; pos += 16) {
+		in = _mm_loadu_si128((const __m128i *)(js + pos));
+		stops = jsmn_stop_mask(in);
+		high = (unsigned int)_mm_movemask_epi8(in);
+		if (high != 0) {
+			if (stops != 0) {
+				high &= (1u << jsmn_ctz64(stops)) - 1;
+			}
+			if (done > pos) {
+				high &= ~0u << (done - pos);
+			}
+			while (high != 0) {
+				k = jsmn_ctz64(high);
+				n = jsmn_utf8_char((const unsigned char *)js + pos + k,
+						len - pos - k);
+				if (n <= 0) {
+					*at = pos + k;
+					return n == 0 ? JSMN_ERROR_UTF8 : JSMN_ERROR_PART;
+				}
+				done = pos + k + n;
+				high &= ~0u << (k + n);
 			}
 		}
+		if (stops != 0) {
+			*at = pos + jsmn_ctz64(stops);
+			return 0;
+		}
+	}
+	if (done > pos) {
+		pos = done;
+	}
+#endif
+#endif
+	while (pos < len) {
+		c = (unsigned char)js[pos];
+		if (c < 0x80) {
+			if (c == '\"' || c == '\\' || c < 0x20) {
+				break;
+			}
+			pos++;
+			continue;
+		}
+		n = jsmn_utf8_char((const unsigned char *)js + pos, len - pos);
+		if (n <= 0) {
+			*at = pos;
+			return n == 0 ? JSMN_ERROR_UTF8 : JSMN_ERROR_PART;
+		}
+		pos += n;
 	}
-	parser->pos = start;
-	return JSMN_ERROR_PART;
+	*at = pos;
+	return 0;
+}
+#endif /* JSMN_UTF8 */
+
+/*
+ * The tokenizer proper, built from Include/jsmn_core.h for each grammar and
+ * token layout.
+ */
+#define JSMN_CORE_PARSER jsmn_parser
+#define JSMN_CORE_INT jsmnint_t
+#define JSMN_CORE_UINT jsmnuint_t
+#define JSMN_CORE_SIZE size_t
+#define JSMN_CORE_RET jsmnint_t
+#define JSMN_POS pos
+#define JSMN_TOKNEXT toknext
+#define JSMN_TOKSUPER toksuper
+#define JSMN_STATE state
+#define JSMN_TOKSTART tokstart
+#define JSMN_DEPTH depth
+#define JSMN_STACK stack
+#define JSMN_PARENT parent
+#ifdef JSMN_PACKED
+/* Longest string or primitive a packed token can describe */
+#define JSMN_CORE_MAX_LEN 0x0fffffff
+#endif
+
+#define JSMN_CORE_CHAR char
+#define JSMN_CORE_UNIT unsigned char
+#ifdef JSMN_SIMD
+#define JSMN_CORE_SPACE_MAP jsmn_space_map
+#define JSMN_CORE_SKIP_SPACE jsmn_skip_whitespace
+#endif
+#ifdef JSMN_UTF8
+#define JSMN_CORE_SCAN_CHECKED jsmn_scan_utf8
+#elif defined(JSMN_SIMD)
+#define JSMN_CORE_SCAN_STRING jsmn_scan_string
+#endif
+
+#define JSMN_CORE(name) name##_strict
+#define JSMN_CORE_PARSE jsmn_parse_strict
+#define JSMN_CORE_TOKEN jsmnplaintok_t
+#define JSMN_CORE_STRICT 1
+#define JSMN_CORE_LINKS 0
+#include "Include/jsmn_core.h"
+
+#define JSMN_CORE(name) name##_lenient
+#define JSMN_CORE_PARSE jsmn_parse_lenient
+#define JSMN_CORE_TOKEN jsmnplaintok_t
+#define JSMN_CORE_STRICT 0
+#define JSMN_CORE_LINKS 0
+#include "Include/jsmn_core.h"
+
+#define JSMN_CORE(name) name##_strict_links
+#define JSMN_CORE_PARSE jsmn_parse_strict_links
+#define JSMN_CORE_TOKEN jsmnlinktok_t
+#define JSMN_CORE_STRICT 1
+#define JSMN_CORE_LINKS 1
+#include "Include/jsmn_core.h"
+
+#define JSMN_CORE(name) name##_lenient_links
+#define JSMN_CORE_PARSE jsmn_parse_lenient_links
+#define JSMN_CORE_TOKEN jsmnlinktok_t
+#define JSMN_CORE_STRICT 0
+#define JSMN_CORE_LINKS 1
+#include "Include/jsmn_core.h"
+
+/* Everything else uses the variant JSMN_STRICT and JSMN_PARENT_LINKS select */
+#if defined(JSMN_STRICT) && defined(JSMN_PARENT_LINKS)
+#define JSMN_VARIANT(name) name##_strict_links
+#elif defined(JSMN_STRICT)
+#define JSMN_VARIANT(name) name##_strict
+#elif defined(JSMN_PARENT_LINKS)
+#define JSMN_VARIANT(name) name##_lenient_links
+#else
+#define JSMN_VARIANT(name) name##_lenient
+#endif
+#define jsmn_alloc_token JSMN_VARIANT(jsmn_alloc_token)
+#define jsmn_parse_string JSMN_VARIANT(jsmn_parse_string)
+#define jsmn_parse_primitive JSMN_VARIANT(jsmn_parse_primitive)
+
+/**
+ * Parse JSON string and fill tokens, strict or not as JSMN_STRICT says.
+ */
+jsmnint_t jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
+		jsmntok_t *tokens, jsmnuint_t num_tokens) {
+	return JSMN_VARIANT(jsmn_parse)(parser, js, len, tokens, num_tokens);
 }
 
 /**
- * Parse JSON string and fill tokens.
+ * Parse JSON string without tokens, reporting values through a callback.
+ * Stands in for what jsmn_parse() reads back from the token array: the type
+ * of every open container is one bit of a bitstack, and of the superior
+ * token only its type and whether it already has a child are kept.
  */
-int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
-		jsmntok_t *tokens, unsigned int num_tokens) {
+jsmnint_t jsmn_parse_events(const char *js, size_t len,
+		jsmn_callback_t callback, void *data) {
+	jsmn_parser lexer;
+	unsigned char objects[JSMN_MAX_DEPTH * 4]; /* bit set: open object */
+	jsmnuint_t depth = 0;
+	jsmntype_t super = JSMN_UNDEFINED; /* type of tokens[toksuper] */
+#ifdef JSMN_STRICT
+	int super_size = 0; /* ... and whether its size is non-zero */
+#endif
+	jsmntype_t last = JSMN_UNDEFINED; /* type of tokens[toknext - 1] */
+	int key = 0; /* the next string is an object key */
+	jsmntype_t type;
+	jsmnint_t count = 0;
+	jsmnint_t start;
 	int r;
-	int i;
-	jsmntok_t *token;
-	int count = parser->toknext;
+#ifdef JSMN_SIMD
+	jsmn_space_map map;
+
+	map.base = map.end = 0;
+#endif
 
-	for (; parser->pos < len && js[parser->pos] != '\0'; parser->pos++) {
-		char c;
-		jsmntype_t type;
+	jsmn_init(&lexer);
+	for (; lexer.pos < len && js[lexer.pos] != '\0'; lexer.pos++) {
+		char c = js[lexer.pos];
 
-		c = js[parser->pos];
 		switch (c) {
 			case '{': case '[':
-				count++;
-				if (tokens == NULL) {
-					break;
-				}
-				token = jsmn_alloc_token(parser, tokens, num_tokens);
-				if (token == NULL)
+				if (depth == sizeof(objects) * 8) {
 					return JSMN_ERROR_NOMEM;
-				if (parser->toksuper != -1) {
-					tokens[parser->toksuper].size++;
-#ifdef JSMN_PARENT_LINKS
-					token->parent = parser->toksuper;
-#endif
 				}
-				token->type = (c == '{' ? JSMN_OBJECT : JSMN_ARRAY);
-				token->start = parser->pos;
-				parser->toksuper = parser->toknext - 1;
+				type = (c == '{' ? JSMN_OBJECT : JSMN_ARRAY);
+				if (callback != NULL && (r = callback(type == JSMN_OBJECT ?
+								JSMN_EVENT_BEGIN_OBJECT : JSMN_EVENT_BEGIN_ARRAY,
+								lexer.pos, lexer.pos + 1, depth, data)) != 0) {
+					return r;
+				}
+				if (type == JSMN_OBJECT) {
+					objects[depth / 8] |= (unsigned char)(1 << depth % 8);
+				} else {
+					objects[depth / 8] &= (unsigned char)~(1 << depth % 8);
+				}
+				depth++;
+				count++;
+				super = last = type;
+				key = type == JSMN_OBJECT;
 				break;
 			case '}': case ']':
-				if (tokens == NULL)
-					break;
 				type = (c == '}' ? JSMN_OBJECT : JSMN_ARRAY);
-#ifdef JSMN_PARENT_LINKS
-				if (parser->toknext < 1) {
+				/* Error if unmatched closing bracket */
+				if (depth == 0) return JSMN_ERROR_INVAL;
+				depth--;
+				if (((objects[depth / 8] >> depth % 8) & 1) !=
+						(type == JSMN_OBJECT)) {
 					return JSMN_ERROR_INVAL;
 				}
-				token = &tokens[parser->toknext - 1];
-				for (;;) {
-					if (token->start != -1 && token->end == -1) {
-						if (token->type != type) {
-							return JSMN_ERROR_INVAL;
-						}
-						token->end = parser->pos + 1;
-						parser->toksuper = token->parent;
-						break;
-					}
-					if (token->parent == -1) {
-						if(token->type != type || parser->toksuper == -1) {
-							return JSMN_ERROR_INVAL;
-						}
-						break;
-					}
-					token = &tokens[token->parent];
-				}
-#else
-				for (i = parser->toknext - 1; i >= 0; i--) {
-					token = &tokens[i];
-					if (token->start != -1 && token->end == -1) {
-						if (token->type != type) {
-							return JSMN_ERROR_INVAL;
-						}
-						parser->toksuper = -1;
-						token->end = parser->pos + 1;
-						break;
-					}
-				}
-				/* Error if unmatched closing bracket */
-				if (i == -1) return JSMN_ERROR_INVAL;
-				for (; i >= 0; i--) {
-					token = &tokens[i];
-					if (token->start != -1 && token->end == -1) {
-						parser->toksuper = i;
-						break;
-					}
+				if (callback != NULL && (r = callback(type == JSMN_OBJECT ?
+								JSMN_EVENT_END_OBJECT : JSMN_EVENT_END_ARRAY,
+								lexer.pos, lexer.pos + 1, depth, data)) != 0) {
+					return r;
 				}
-#endif
+				super = depth == 0 ? JSMN_UNDEFINED :
+					(objects[(depth - 1) / 8] >> (depth - 1) % 8) & 1 ?
+					JSMN_OBJECT : JSMN_ARRAY;
+				key = 0;
 				break;
 			case '\"':
-				r = jsmn_parse_string(parser, js, len, tokens, num_tokens);
+				r = jsmn_parse_string(&lexer, js, len, NULL, 0);
 				if (r < 0) return r;
+				if (callback != NULL && (r = callback(key ? JSMN_EVENT_KEY :
+								JSMN_EVENT_STRING, lexer.tokstart + 1, lexer.pos,
+								depth, data)) != 0) {
+					return r;
+				}
 				count++;
-				if (parser->toksuper != -1 && tokens != NULL)
-					tokens[parser->toksuper].size++;
+#ifdef JSMN_STRICT
+				super_size = 1;
+#endif
+				last = JSMN_STRING;
+				key = 0;
 				break;
 			case '\t' : case '\r' : case '\n' : case ' ':
+#ifdef JSMN_SIMD
+				lexer.pos = jsmn_skip_whitespace(&map, js, len,
+						lexer.pos + 1) - 1;
+#endif
 				break;
 			case ':':
-				parser->toksuper = parser->toknext - 1;
+				/* The last token never has children of its own */
+				super = last;
+#ifdef JSMN_STRICT
+				super_size = 0;
+#endif
+				key = 0;
 				break;
 			case ',':
-				if (tokens != NULL && parser->toksuper != -1 &&
-						tokens[parser->toksuper].type != JSMN_ARRAY &&
-						tokens[parser->toksuper].type != JSMN_OBJECT) {
-#ifdef JSMN_PARENT_LINKS
-					parser->toksuper = tokens[parser->toksuper].parent;
-#else
-					for (i = parser->toknext - 1; i >= 0; i--) {
-						if (tokens[i].type == JSMN_ARRAY || tokens[i].type == JSMN_OBJECT) {
-							if (tokens[i].start != -1 && tokens[i].end == -1) {
-								parser->toksuper = i;
-								break;
-							}
-						}
-					}
-#endif
+				if (super != JSMN_UNDEFINED && super != JSMN_ARRAY &&
+						super != JSMN_OBJECT && depth > 0) {
+					super = (objects[(depth - 1) / 8] >> (depth - 1) % 8) & 1 ?
+						JSMN_OBJECT : JSMN_ARRAY;
 				}
+				key = depth > 0 && (objects[(depth - 1) / 8] >> (depth - 1) % 8) & 1;
 				break;
 #ifdef JSMN_STRICT
-			/* In strict mode primitives are: numbers and booleans */
 			case '-': case '0': case '1' : case '2': case '3' : case '4':
 			case '5': case '6': case '7' : case '8': case '9':
 			case 't': case 'f': case 'n' :
-				/* And they must not be keys of the object */
-				if (tokens != NULL && parser->toksuper != -1) {
-					jsmntok_t *t = &tokens[parser->toksuper];
-					if (t->type == JSMN_OBJECT ||
-							(t->type == JSMN_STRING && t->size != 0)) {
-						return JSMN_ERROR_INVAL;
-					}
+				if (super == JSMN_OBJECT ||
+						(super == JSMN_STRING && super_size != 0)) {
+					return JSMN_ERROR_INVAL;
 				}
 #else
-			/* In non-strict mode every unquoted value is a primitive */
 			default:
 #endif
-				r = jsmn_parse_primitive(parser, js, len, tokens, num_tokens);
+				start = lexer.pos;
+				r = jsmn_parse_primitive(&lexer, js, len, NULL, 0);
 				if (r < 0) return r;
+				if (callback != NULL && (r = callback(JSMN_EVENT_PRIMITIVE,
+								start, lexer.pos + 1, depth, data)) != 0) {
+					return r;
+				}
 				count++;
-				if (parser->toksuper != -1 && tokens != NULL)
-					tokens[parser->toksuper].size++;
+#ifdef JSMN_STRICT
+				super_size = 1;
+#endif
+				last = JSMN_PRIMITIVE;
+				key = 0;
 				break;
 
 #ifdef JSMN_STRICT
-			/* Unexpected char in strict mode */
 			default:
 				return JSMN_ERROR_INVAL;
 #endif
 		}
 	}
 
-	if (tokens != NULL) {
-		for (i = parser->toknext - 1; i >= 0; i--) {
-			/* Unmatched opened object or array */
-			if (tokens[i].start != -1 && tokens[i].end == -1) {
-				return JSMN_ERROR_PART;
+	/* Unmatched opened object or array */
+	if (depth > 0) {
+		return JSMN_ERROR_PART;
+	}
+
+	return count;
+}
+
+/**
+ * Validate JSON string without tokens.
+ */
+jsmnint_t jsmn_validate(const char *js, size_t len) {
+	return jsmn_parse_events(js, len, NULL, NULL);
+}
+
+/**
+ * Parse JSON string, growing the token array geometrically when it is full.
+ */
+jsmnint_t jsmn_parse_grow(jsmn_parser *parser, const char *js, size_t len,
+		jsmntok_t **tokens, jsmnuint_t *num_tokens,
+		jsmn_realloc_t realloc_fn, void *data) {
+	for (;;) {
+		jsmnuint_t n;
+		jsmntok_t *t;
+		/* A NULL array would make jsmn_parse() count tokens instead */
+		if (*tokens != NULL) {
+			jsmnint_t r = jsmn_parse(parser, js, len, *tokens, *num_tokens);
+			if (r != JSMN_ERROR_NOMEM) {
+				return r;
 			}
 		}
+		/* The parser stopped at the token it could not store, resume there */
+		if (*tokens == NULL || *num_tokens < 8) {
+			n = 16;
+		} else if (*num_tokens > ((jsmnuint_t)-1 >> 1) / 2 ||
+				(size_t)*num_tokens * 2 > (size_t)-1 / sizeof(jsmntok_t)) {
+			/* Doubled, the count would not fit a jsmnint_t or its bytes a size_t */
+			return JSMN_ERROR_NOMEM;
+		} else {
+			n = *num_tokens * 2;
+		}
+		t = (jsmntok_t *)realloc_fn(*tokens, n * sizeof(jsmntok_t), data);
+		if (t == NULL) {
+			return JSMN_ERROR_NOMEM;
+		}
+		*tokens = t;
+		*num_tokens = n;
 	}
+}
 
+/**
+ * Returns the number of tokens in the value starting at tokens[0], going by
+ * their sizes: a key counts its value, a container its children.
+ */
+static jsmnuint_t jsmn_value_tokens(const jsmntok_t *tokens, jsmnuint_t n) {
+	jsmnuint_t i, pending = 1;
+	for (i = 0; i < n && pending > 0; i++) {
+		pending += jsmn_tok_size(&tokens[i]) - 1;
+	}
+	return i;
+}
+
+/**
+ * Parse concatenated JSON values, one record each, reusing the token array.
+ */
+jsmnint_t jsmn_parse_records(const char *js, size_t len,
+		jsmntok_t *tokens, jsmnuint_t num_tokens,
+		jsmnrecord_t *records, jsmnuint_t num_records, size_t *used) {
+	jsmn_parser parser;
+	jsmnuint_t i, n, count = 0;
+	jsmnint_t r;
+
+	jsmn_init(&parser);
+	r = jsmn_parse(&parser, js, len, tokens, num_tokens);
+
+	/* Where the first record that is not complete starts */
+	if (parser.state != JSMN_STATE_NONE) {
+		*used = parser.tokstart;
+	} else if (r < 0 && parser.depth == 0) {
+		*used = parser.pos;
+	} else {
+		*used = len;
+	}
+
+	for (i = 0; i < parser.toknext; i += n) {
+		size_t start = jsmn_tok_start(&tokens[i]) -
+			(jsmn_tok_type(&tokens[i]) == JSMN_STRING);
+		n = jsmn_value_tokens(tokens + i, parser.toknext - i);
+		if (count == num_records || (i + n == parser.toknext &&
+					(parser.depth > 0 ||
+					 /* A primitive at the very end may go on */
+					 (jsmn_tok_type(&tokens[i]) == JSMN_PRIMITIVE &&
+					  (size_t)jsmn_tok_end(&tokens[i]) == len)))) {
+			*used = start;
+			break;
+		}
+		records[count].first = i;
+		records[count].count = n;
+		count++;
+	}
+
+	if (count == 0 && r < 0 && r != JSMN_ERROR_PART) {
+		return r;
+	}
 	return count;
 }
 
+/**
+ * FNV-1a hash of a key, seeded with the index of its object.
+ */
+static jsmnuint_t jsmn_hash(const char *key, size_t len, jsmnint_t obj) {
+	unsigned int h = (2166136261u ^ (unsigned int)obj) * 16777619u;
+	size_t i;
+	for (i = 0; i < len; i++) {
+		h = (h ^ (unsigned char)key[i]) * 16777619u;
+	}
+	return h ^ h >> 16;
+}
+
+jsmnuint_t jsmn_key_index_size(const jsmntok_t *tokens, jsmnuint_t num_tokens) {
+	jsmnuint_t i, keys = 0, size = 1;
+	for (i = 0; i < num_tokens; i++) {
+		if (jsmn_tok_type(&tokens[i]) == JSMN_OBJECT) {
+			keys += jsmn_tok_size(&tokens[i]);
+		}
+	}
+	while (size < keys * 2 && (jsmnuint_t)(size << 1) != 0) {
+		size <<= 1;
+	}
+	return size;
+}
+
+/**
+ * Index every key of every object, going from one key to the next over the
+ * tokens of its value.
+ */
+jsmnint_t jsmn_build_key_index(jsmnkeyindex_t *index, const char *js,
+		const jsmntok_t *tokens, jsmnuint_t num_tokens) {
+	jsmnuint_t i, j, k, h, keys = 0, mask = index->size - 1;
+
+	if (index->size == 0 || (index->size & mask) != 0) {
+		return JSMN_ERROR_NOMEM;
+	}
+	for (h = 0; h < index->size; h++) {
+		index->slots[h].key = 0;
+	}
+	for (i = 0; i < num_tokens; i++) {
+		if (jsmn_tok_type(&tokens[i]) != JSMN_OBJECT) {
+			continue;
+		}
+		k = i + 1;
+		for (j = 0; j < (jsmnuint_t)jsmn_tok_size(&tokens[i]) && k < num_tokens; j++) {
+			const jsmntok_t *key = &tokens[k];
+			/* An object or array as key (non-strict) hashes as empty */
+			size_t len = jsmn_tok_end(key) > jsmn_tok_start(key) ?
+				(size_t)(jsmn_tok_end(key) - jsmn_tok_start(key)) : 0;
+			/* Keep a free slot, where lookups stop */
+			if (keys + 1 >= index->size) {
+				return JSMN_ERROR_NOMEM;
+			}
+			h = jsmn_hash(js + jsmn_tok_start(key), len, i) & mask;
+			while (index->slots[h].key != 0) {
+				h = (h + 1) & mask;
+			}
+			index->slots[h].object = i;
+			index->slots[h].key = k;
+			keys++;
+			k += jsmn_value_tokens(key, num_tokens - k);
+		}
+	}
+	return keys;
+}
+
+jsmnint_t jsmn_lookup(const jsmnkeyindex_t *index, const char *js,
+		const jsmntok_t *tokens, jsmnint_t obj, const char *key) {
+	jsmnuint_t h, mask = index->size - 1;
+	size_t i, len = 0;
+	jsmnint_t k;
+
+	while (key[len] != '\0') {
+		len++;
+	}
+	for (h = jsmn_hash(key, len, obj) & mask; (k = index->slots[h].key) != 0;
+			h = (h + 1) & mask) {
+		const jsmntok_t *t = &tokens[k];
+		if (index->slots[h].object != obj ||
+				(size_t)(jsmn_tok_end(t) - jsmn_tok_start(t)) != len) {
+			continue;
+		}
+		for (i = 0; i < len && js[jsmn_tok_start(t) + i] == key[i]; i++);
+		if (i == len) {
+			return jsmn_tok_size(t) > 0 ? k + 1 : -1;
+		}
+	}
+	return -1;
+}
+
+/**
+ * Returns the number of tokens of the value at tokens[i], a key counting its
+ * value.
+ */
+static jsmnuint_t jsmn_extent(const jsmntok_t *tokens, jsmnuint_t num_tokens,
+		jsmnuint_t i) {
+#ifdef JSMN_SPANS
+	const jsmntok_t *t = &tokens[i];
+	if (jsmn_tok_type(t) >= JSMN_STRING) {
+		return jsmn_tok_size(t) > 0 && i + 1 < num_tokens ?
+			1 + jsmn_extent(tokens, num_tokens, i + 1) : 1;
+	}
+	/* Not closed: it runs to the end */
+	return jsmn_tok_span(t) > 0 ? (jsmnuint_t)jsmn_tok_span(t) : num_tokens - i;
+#else
+	return jsmn_value_tokens(tokens + i, num_tokens - i);
+#endif
+}
+
+/**
+ * Returns the token right above tokens[i], or -1.
+ */
+static jsmnint_t jsmn_cursor_above(const jsmncursor_t *cursor, jsmnint_t i) {
+	jsmnint_t j;
+	if (cursor->depth == 0) {
+		return -1;
+	}
+	if (cursor->depth <= JSMN_MAX_DEPTH) {
+		return cursor->stack[cursor->depth - 1];
+	}
+#ifdef JSMN_PARENT_LINKS
+	(void)j;
+	return cursor->tokens[i].parent;
+#else
+	/* Deeper than the stack: the closest token whose value covers i */
+	for (j = i - 1; j >= 0; j--) {
+		if (j + (jsmnint_t)jsmn_extent(cursor->tokens, cursor->num_tokens,
+					j) > i) {
+			return j;
+		}
+	}
+	return -1;
+#endif
+}
+
+void jsmn_cursor_init(jsmncursor_t *cursor, const jsmntok_t *tokens,
+		jsmnuint_t num_tokens) {
+	cursor->tokens = tokens;
+	cursor->num_tokens = num_tokens;
+	cursor->pos = num_tokens > 0 ? 0 : -1;
+	cursor->depth = 0;
+}
+
+jsmnint_t jsmn_cursor_first_child(jsmncursor_t *cursor) {
+	jsmnint_t i = cursor->pos;
+	if (i < 0 || (jsmnuint_t)i + 1 >= cursor->num_tokens ||
+			jsmn_tok_size(&cursor->tokens[i]) == 0) {
+		return -1;
+	}
+	if (cursor->depth < JSMN_MAX_DEPTH) {
+		cursor->stack[cursor->depth] = i;
+		cursor->left[cursor->depth] = jsmn_tok_size(&cursor->tokens[i]) - 1;
+	}
+	cursor->depth++;
+	return cursor->pos = i + 1;
+}
+
+jsmnint_t jsmn_cursor_next_sibling(jsmncursor_t *cursor) {
+	jsmnint_t i = cursor->pos, above;
+	jsmnuint_t end = cursor->num_tokens, next;
+	if (i < 0) {
+		return -1;
+	}
+	if (cursor->depth > 0 && cursor->depth <= JSMN_MAX_DEPTH) {
+		if (cursor->left[cursor->depth - 1] == 0) {
+			return -1;
+		}
+		cursor->left[cursor->depth - 1]--;
+	} else if ((above = jsmn_cursor_above(cursor, i)) >= 0) {
+		end = above + jsmn_extent(cursor->tokens, cursor->num_tokens, above);
+	}
+	next = i + jsmn_extent(cursor->tokens, cursor->num_tokens, i);
+	if (next >= end) {
+		return -1;
+	}
+	return cursor->pos = next;
+}
+
+jsmnint_t jsmn_cursor_parent(jsmncursor_t *cursor) {
+	jsmnint_t above;
+	if (cursor->pos < 0) {
+		return -1;
+	}
+	above = jsmn_cursor_above(cursor, cursor->pos);
+	if (above < 0) {
+		return -1;
+	}
+	cursor->depth--;
+	return cursor->pos = above;
+}
+
+/**
+ * Parses the decimal digits at s, up to len of them. Returns their value, or
+ * -1 if there are none, there are others or the value does not fit.
+ */
+static jsmnint_t jsmn_path_number(const char *s, jsmnuint_t len) {
+	jsmnuint_t i, n = 0, max = ((jsmnuint_t)-1 >> 1) / 10;
+	if (len == 0) {
+		return -1;
+	}
+	for (i = 0; i < len; i++) {
+		if (s[i] < '0' || s[i] > '9' || n > max) {
+			return -1;
+		}
+		n = n * 10 + (jsmnuint_t)(s[i] - '0');
+	}
+	return (jsmnint_t)n;
+}
+
+/**
+ * Appends a step to a path.
+ */
+static jsmnstep_t *jsmn_path_step(jsmnpath_t *path, jsmnsteptype_t type,
+		jsmnuint_t start, jsmnuint_t len) {
+	jsmnstep_t *step;
+	if (path->num_steps >= JSMN_PATH_STEPS) {
+		return NULL;
+	}
+	step = &path->steps[path->num_steps++];
+	step->type = type;
+	step->tilde = 0;
+	step->start = start;
+	step->len = len;
+	step->index = -1;
+	return step;
+}
+
+jsmnint_t jsmn_path_compile(jsmnpath_t *path, const char *expr) {
+	jsmnstep_t *step;
+	jsmnuint_t i = 0, j;
+
+	path->expr = expr;
+	path->num_steps = 0;
+	if (expr[0] == '$') {
+		for (i = 1; expr[i] != '\0'; i = j) {
+			if (expr[i] == '.') {
+				for (j = i + 1; expr[j] != '\0' && expr[j] != '.' &&
+						expr[j] != '['; j++);
+				if (j == i + 1) {
+					return JSMN_ERROR_INVAL;
+				}
+				step = j == i + 2 && expr[i + 1] == '*' ?
+					jsmn_path_step(path, JSMN_STEP_ANY_MEMBER, 0, 0) :
+					jsmn_path_step(path, JSMN_STEP_NAME, i + 1, j - i - 1);
+			} else if (expr[i] == '[' && expr[i + 1] == '\'') {
+				for (j = i + 2; expr[j] != '\0' && expr[j] != '\''; j++);
+				if (expr[j] != '\'' || expr[j + 1] != ']') {
+					return JSMN_ERROR_INVAL;
+				}
+				step = jsmn_path_step(path, JSMN_STEP_NAME, i + 2, j - i - 2);
+				j += 2;
+			} else if (expr[i] == '[') {
+				for (j = i + 1; expr[j] != '\0' && expr[j] != ']'; j++);
+				if (expr[j] != ']') {
+					return JSMN_ERROR_INVAL;
+				}
+				if (j == i + 2 && expr[i + 1] == '*') {
+					step = jsmn_path_step(path, JSMN_STEP_ANY_ELEMENT, 0, 0);
+				} else {
+					jsmnint_t index = jsmn_path_number(expr + i + 1, j - i - 1);
+					if (index < 0) {
+						return JSMN_ERROR_INVAL;
+					}
+					step = jsmn_path_step(path, JSMN_STEP_INDEX, 0, 0);
+					if (step != NULL) {
+						step->index = index;
+					}
+				}
+				j++;
+			} else {
+				return JSMN_ERROR_INVAL;
+			}
+			if (step == NULL) {
+				return JSMN_ERROR_NOMEM;
+			}
+		}
+		return path->num_steps;
+	}
+
+	/* JSON Pointer: "/"-separated names, "~0" for '~' and "~1" for '/' */
+	while (expr[i] != '\0') {
+		if (expr[i] != '/') {
+			return JSMN_ERROR_INVAL;
+		}
+		step = jsmn_path_step(path, JSMN_STEP_NAME, i + 1, 0);
+		if (step == NULL) {
+			return JSMN_ERROR_NOMEM;
+		}
+		for (j = i + 1; expr[j] != '\0' && expr[j] != '/'; j++) {
+			if (expr[j] == '~') {
+				if (expr[j + 1] != '0' && expr[j + 1] != '1') {
+					return JSMN_ERROR_INVAL;
+				}
+				step->tilde = 1;
+				j++;
+			}
+		}
+		step->len = j - i - 1;
+		/* An array index has no leading zeros */
+		if (expr[i + 1] != '0' || step->len == 1) {
+			step->index = jsmn_path_number(expr + i + 1, step->len);
+		}
+		i = j;
+	}
+	return path->num_steps;
+}
+
+/**
+ * Value of a hexadecimal digit, or -1.
+ */
+static int jsmn_hex_digit(char c) {
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	}
+	if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+		return (c | 0x20) - 'a' + 10;
+	}
+	return -1;
+}
+
+/**
+ * Value of the "\uXXXX" escape at js[i], or -1 if there is none before end.
+ */
+static long jsmn_unicode_escape(const char *js, jsmnuint_t i, jsmnuint_t end) {
+	long c = 0;
+	int k, d;
+	if (i + 6 > end || js[i] != '\\' || js[i + 1] != 'u') {
+		return -1;
+	}
+	for (k = 2; k < 6; k++) {
+		if ((d = jsmn_hex_digit(js[i + k])) < 0) {
+			return -1;
+		}
+		c = c << 4 | d;
+	}
+	return c;
+}
+
+/**
+ * Decodes the character of a JSON string at js[*i], an escape sequence or a
+ * byte, moves *i past it and stores it in UTF-8 into buf. Returns the number
+ * of bytes stored. A malformed escape is taken as it is written.
+ */
+static int jsmn_decode_char(const char *js, jsmnuint_t *i, jsmnuint_t end,
+		unsigned char *buf) {
+	long c, low;
+	if (js[*i] != '\\' || *i + 1 >= end) {
+		buf[0] = (unsigned char)js[(*i)++];
+		return 1;
+	}
+	switch (js[*i + 1]) {
+		case 'b': c = '\b'; break;
+		case 'f': c = '\f'; break;
+		case 'n': c = '\n'; break;
+		case 'r': c = '\r'; break;
+		case 't': c = '\t'; break;
+		case 'u':
+			if ((c = jsmn_unicode_escape(js, *i, end)) < 0) {
+				buf[0] = (unsigned char)js[(*i)++];
+				return 1;
+			}
+			*i += 6;
+			/* A surrogate pair makes one character */
+			if (c >= 0xD800 && c < 0xDC00 &&
+					(low = jsmn_unicode_escape(js, *i, end)) >= 0xDC00 &&
+					low < 0xE000) {
+				c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+				*i += 6;
+			} else if (c >= 0xD800 && c < 0xE000) {
+				/* An unpaired surrogate is no character at all */
+				c = 0xFFFD;
+			}
+			if (c < 0x80) {
+				buf[0] = (unsigned char)c;
+				return 1;
+			}
+			if (c < 0x800) {
+				buf[0] = (unsigned char)(0xC0 | c >> 6);
+				buf[1] = (unsigned char)(0x80 | (c & 0x3F));
+				return 2;
+			}
+			if (c < 0x10000) {
+				buf[0] = (unsigned char)(0xE0 | c >> 12);
+				buf[1] = (unsigned char)(0x80 | (c >> 6 & 0x3F));
+				buf[2] = (unsigned char)(0x80 | (c & 0x3F));
+				return 3;
+			}
+			buf[0] = (unsigned char)(0xF0 | c >> 18);
+			buf[1] = (unsigned char)(0x80 | (c >> 12 & 0x3F));
+			buf[2] = (unsigned char)(0x80 | (c >> 6 & 0x3F));
+			buf[3] = (unsigned char)(0x80 | (c & 0x3F));
+			return 4;
+		default: c = js[*i + 1]; break;
+	}
+	*i += 2;
+	buf[0] = (unsigned char)c;
+	return 1;
+}
+
+/**
+ * Position of the first backslash at or after i, or end if there is none.
+ */
+static jsmnuint_t jsmn_next_escape(const char *js, jsmnuint_t i,
+		jsmnuint_t end) {
+#ifdef JSMN_SIMD
+	/* The scan also stops at control bytes (non-strict), which are plain */
+	while ((i = (jsmnuint_t)jsmn_scan_string(js, end, i)) < end &&
+			js[i] != '\\') {
+		i++;
+	}
+#else
+	while (i < end && js[i] != '\\') {
+		i++;
+	}
+#endif
+	return i;
+}
+
+/**
+ * Copies a run of string body that has no escapes.
+ */
+static void jsmn_copy_run(char *dst, const char *src, jsmnuint_t n) {
+	jsmnuint_t k = 0;
+#if defined(JSMN_SIMD) && defined(__AVX2__)
+	for (; k + 32 <= n; k += 32) {
+		_mm256_storeu_si256((__m256i *)(dst + k),
+				_mm256_loadu_si256((const __m256i *)(src + k)));
+	}
+#elif defined(JSMN_SSE2)
+	for (; k + 16 <= n; k += 16) {
+		_mm_storeu_si128((__m128i *)(dst + k),
+				_mm_loadu_si128((const __m128i *)(src + k)));
+	}
+#endif
+	for (; k < n; k++) {
+		dst[k] = src[k];
+	}
+}
+
+jsmnint_t jsmn_unescaped_length(const char *js, const jsmntok_t *t) {
+	jsmnuint_t i, j, end;
+	jsmnint_t n;
+	unsigned char buf[4];
+
+	if (jsmn_tok_type(t) < JSMN_STRING) {
+		return JSMN_ERROR_INVAL;
+	}
+	i = jsmn_tok_start(t);
+	end = jsmn_tok_end(t);
+	/* Only the escapes change the length, the rest is copied as it is */
+	n = (jsmnint_t)(end - i);
+	while ((i = jsmn_next_escape(js, i, end)) < end) {
+		j = i;
+		n += jsmn_decode_char(js, &i, end, buf);
+		n -= (jsmnint_t)(i - j);
+	}
+	return n;
+}
+
+jsmnint_t jsmn_unescape(const char *js, const jsmntok_t *t, char *buf,
+		size_t size) {
+	jsmnuint_t i, run, end;
+	size_t n = 0;
+	unsigned char c[4];
+	int k, m;
+
+	if (jsmn_tok_type(t) < JSMN_STRING) {
+		return JSMN_ERROR_INVAL;
+	}
+	i = jsmn_tok_start(t);
+	end = jsmn_tok_end(t);
+	while (i < end) {
+		run = jsmn_next_escape(js, i, end);
+		if (run - i > size - n) {
+			return JSMN_ERROR_NOMEM;
+		}
+		jsmn_copy_run(buf + n, js + i, run - i);
+		n += run - i;
+		if (run == end) {
+			break;
+		}
+		i = run;
+		m = jsmn_decode_char(js, &i, end, c);
+		if ((size_t)m > size - n) {
+			return JSMN_ERROR_NOMEM;
+		}
+		for (k = 0; k < m; k++) {
+			buf[n++] = (char)c[k];
+		}
+	}
+	return (jsmnint_t)n;
+}
+
+/**
+ * Tells whether a key, with its escapes decoded, is the name of a step.
+ */
+static int jsmn_step_matches(const jsmnpath_t *path, const jsmnstep_t *step,
+		const char *js, const jsmntok_t *key) {
+	const char *name = path->expr + step->start;
+	jsmnuint_t i, end, j = 0;
+	unsigned char buf[4], c;
+	int k, n;
+
+	/* An object or array as key (non-strict) has no name */
+	if (jsmn_tok_type(key) < JSMN_STRING) {
+		return 0;
+	}
+	i = jsmn_tok_start(key);
+	end = jsmn_tok_end(key);
+	while (i < end) {
+		n = jsmn_decode_char(js, &i, end, buf);
+		for (k = 0; k < n; k++) {
+			if (j >= step->len) {
+				return 0;
+			}
+			c = (unsigned char)name[j++];
+			if (c == '~' && step->tilde) {
+				c = name[j++] == '0' ? '~' : '/';
+			}
+			if (c != buf[k]) {
+				return 0;
+			}
+		}
+	}
+	return j == step->len;
+}
+
+/**
+ * State of jsmn_path_eval().
+ */
+typedef struct {
+	const jsmnpath_t *path;
+	const char *js;
+	const jsmntok_t *tokens;
+	jsmnuint_t num_tokens;
+	jsmnint_t *matches;
+	jsmnuint_t num_matches;
+	jsmnuint_t count;
+} jsmn_query;
+
+/**
+ * Matches the steps from s on against the value at tokens[i]. Returns
+ * non-zero once the matches are full.
+ */
+static int jsmn_query_value(jsmn_query *q, jsmnuint_t s, jsmnuint_t i) {
+	const jsmnstep_t *step = &q->path->steps[s];
+	const jsmntok_t *t = &q->tokens[i];
+	jsmnuint_t j, k, n;
+	jsmntype_t type = jsmn_tok_type(t);
+
+	if (s == q->path->num_steps) {
+		if (q->matches != NULL) {
+			q->matches[q->count] = i;
+		}
+		return ++q->count == q->num_matches && q->matches != NULL;
+	}
+	if (type == JSMN_OBJECT && (step->type == JSMN_STEP_NAME ||
+				step->type == JSMN_STEP_ANY_MEMBER)) {
+		k = i + 1;
+		for (j = 0; j < (jsmnuint_t)jsmn_tok_size(t) && k < q->num_tokens; j++) {
+			if (jsmn_tok_size(&q->tokens[k]) > 0 && k + 1 < q->num_tokens) {
+				if (step->type == JSMN_STEP_ANY_MEMBER) {
+					if (jsmn_query_value(q, s + 1, k + 1)) {
+						return 1;
+					}
+				} else if (jsmn_step_matches(q->path, step, q->js,
+							&q->tokens[k])) {
+					return jsmn_query_value(q, s + 1, k + 1);
+				}
+			}
+			/* Skip the member, key and value, without looking inside */
+			k += jsmn_extent(q->tokens, q->num_tokens, k);
+		}
+	} else if (type == JSMN_ARRAY && step->type != JSMN_STEP_ANY_MEMBER) {
+		if (step->type != JSMN_STEP_ANY_ELEMENT &&
+				(step->index < 0 || step->index >= jsmn_tok_size(t))) {
+			return 0;
+		}
+		n = step->type == JSMN_STEP_ANY_ELEMENT ? 0 : (jsmnuint_t)step->index;
+		k = i + 1;
+		for (j = 0; j < (jsmnuint_t)jsmn_tok_size(t) && k < q->num_tokens; j++) {
+			if (step->type == JSMN_STEP_ANY_ELEMENT) {
+				if (jsmn_query_value(q, s + 1, k)) {
+					return 1;
+				}
+			} else if (j == n) {
+				return jsmn_query_value(q, s + 1, k);
+			}
+			k += jsmn_extent(q->tokens, q->num_tokens, k);
+		}
+	}
+	return 0;
+}
+
+jsmnint_t jsmn_path_eval(const jsmnpath_t *path, const char *js,
+		const jsmntok_t *tokens, jsmnuint_t num_tokens,
+		jsmnint_t *matches, jsmnuint_t num_matches) {
+	jsmn_query q;
+
+	if (num_tokens == 0 || (matches != NULL && num_matches == 0)) {
+		return 0;
+	}
+	q.path = path;
+	q.js = js;
+	q.tokens = tokens;
+	q.num_tokens = num_tokens;
+	q.matches = matches;
+	q.num_matches = num_matches;
+	q.count = 0;
+	jsmn_query_value(&q, 0, 0);
+	return q.count;
+}
+
+/**
+ * State of jsmn_parse_select(): a parser for the position and the tokens,
+ * and the paths of the values to keep.
+ */
+typedef struct {
+	jsmn_parser parser;
+	const char *js;
+	size_t len;
+	jsmntok_t *tokens;
+	jsmnuint_t num_tokens;
+	const jsmnpath_t *paths;
+	jsmnuint_t num_paths;
+} jsmn_selector;
+
+/**
+ * Skips whitespace and returns the next character, or '\0' at the end.
+ */
+static char jsmn_select_peek(jsmn_selector *s) {
+	char c;
+	for (; s->parser.pos < s->len; s->parser.pos++) {
+		c = s->js[s->parser.pos];
+		if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+			return c;
+		}
+	}
+	return '\0';
+}
+
+/**
+ * Moves past the value at the current position without any tokens, keeping
+ * track of nothing but nesting depth and whether it is inside a string.
+ */
+static int jsmn_select_skip(jsmn_selector *s) {
+	const char *js = s->js;
+	size_t pos = s->parser.pos, len = s->len;
+	jsmnuint_t depth = 0;
+	char c;
+
+	while (pos < len && (c = js[pos]) != '\0') {
+		if (c == '\"') {
+			/* Skip the string body, escapes included */
+			for (pos++; pos < len; pos++) {
+#ifdef JSMN_SIMD
+				pos = jsmn_scan_string(js, len, pos);
+				if (pos >= len) {
+					break;
+				}
+#endif
+				if (js[pos] == '\"') {
+					break;
+				}
+				if (js[pos] == '\\') {
+					pos++;
+				}
+			}
+			if (pos >= len) {
+				return JSMN_ERROR_PART;
+			}
+			pos++;
+			if (depth == 0) {
+				break;
+			}
+		} else if (c == '{' || c == '[') {
+			depth++;
+			pos++;
+		} else if (c == '}' || c == ']') {
+			if (depth == 0) {
+				break;
+			}
+			pos++;
+			if (--depth == 0) {
+				break;
+			}
+		} else if (depth == 0 && (c == ',' || c == ':' || c == ' ' ||
+					c == '\t' || c == '\n' || c == '\r')) {
+			break;
+		} else {
+			pos++;
+		}
+	}
+	if (depth > 0) {
+		return JSMN_ERROR_PART;
+	}
+	if (pos == s->parser.pos) {
+		return JSMN_ERROR_INVAL;
+	}
+	s->parser.pos = pos;
+	return 0;
+}
+
+/**
+ * Tells what to do with a value starting with c for the paths in alive,
+ * whose first depth steps matched: 2 if one of them ends there, so that it
+ * is kept whole, 1 if it is an object or array one of them goes into, and 0
+ * if it is skipped.
+ */
+static int jsmn_select_wants(const jsmn_selector *s, unsigned long alive,
+		jsmnuint_t depth, char c) {
+	const jsmnstep_t *step;
+	jsmnuint_t p;
+	int r = 0;
+
+	for (p = 0; p < s->num_paths; p++) {
+		if ((alive >> p & 1) == 0) {
+			continue;
+		}
+		if (s->paths[p].num_steps == depth) {
+			return 2;
+		}
+		step = &s->paths[p].steps[depth];
+		if ((c == '{' && (step->type == JSMN_STEP_NAME ||
+						step->type == JSMN_STEP_ANY_MEMBER)) ||
+				(c == '[' && (step->type == JSMN_STEP_INDEX ||
+							  step->type == JSMN_STEP_ANY_ELEMENT ||
+							  step->index >= 0))) {
+			r = 1;
+		}
+	}
+	return r;
+}
+
+/**
+ * Emits a token for the string or primitive at the current position, the
+ * child of tokens[super], and moves past it.
+ */
+static int jsmn_select_scalar(jsmn_selector *s, jsmnint_t super) {
+	int r;
+	s->parser.toksuper = super;
+	if (s->js[s->parser.pos] == '\"') {
+		r = jsmn_parse_string(&s->parser, s->js, s->len, s->tokens,
+				s->num_tokens);
+	} else {
+		r = jsmn_parse_primitive(&s->parser, s->js, s->len, s->tokens,
+				s->num_tokens);
+	}
+	if (r < 0) {
+		return r;
+	}
+	s->parser.pos++;
+	if (super != -1) {
+		jsmn_tok_add_child(&s->tokens[super]);
+	}
+	return 0;
+}
+
+/**
+ * Parses the value at the current position, the child of tokens[super], for
+ * the paths in alive, whose first depth steps matched. A value one of them
+ * ends at is parsed whole, an object or array one of them goes into gets a
+ * token and only the members it selects, and anything else is skipped.
+ */
+static int jsmn_select_value(jsmn_selector *s, unsigned long alive,
+		jsmnuint_t depth, jsmnint_t super) {
+	jsmn_parser sub;
+	jsmntok_t *token, name;
+	jsmnint_t i, r;
+	jsmnuint_t p, n = 0;
+	size_t start, key, end;
+	unsigned long next;
+	const jsmnstep_t *step;
+	char c = jsmn_select_peek(s), close = c == '{' ? '}' : ']';
+
+	if (c == '\0') {
+		return JSMN_ERROR_PART;
+	}
+	switch (jsmn_select_wants(s, alive, depth, c)) {
+		case 0:
+			return jsmn_select_skip(s);
+		case 2:
+			if (c != '{' && c != '[') {
+				return jsmn_select_scalar(s, super);
+			}
+			/* Find its end, then parse it whole in place */
+			start = s->parser.pos;
+			if ((r = jsmn_select_skip(s)) < 0) {
+				return r;
+			}
+			end = s->parser.pos;
+			jsmn_init(&sub);
+			sub.pos = start;
+			sub.toknext = s->parser.toknext;
+			r = jsmn_parse(&sub, s->js, end, s->tokens, s->num_tokens);
+			if (r < 0) {
+				return r;
+			}
+#ifdef JSMN_PARENT_LINKS
+			s->tokens[s->parser.toknext].parent = super;
+#endif
+			s->parser.toknext = sub.toknext;
+			if (super != -1) {
+				jsmn_tok_add_child(&s->tokens[super]);
+			}
+			return 0;
+	}
+
+	token = jsmn_alloc_token(&s->parser, s->tokens, s->num_tokens);
+	if (token == NULL) {
+		return JSMN_ERROR_NOMEM;
+	}
+	jsmn_tok_fill(token, c == '{' ? JSMN_OBJECT : JSMN_ARRAY,
+			s->parser.pos, -1);
+#ifdef JSMN_PARENT_LINKS
+	token->parent = super;
+#endif
+	if (super != -1) {
+		jsmn_tok_add_child(&s->tokens[super]);
+	}
+	i = s->parser.toknext - 1;
+	s->parser.pos++;
+
+	for (;; n++) {
+		c = jsmn_select_peek(s);
+		if (c == close) {
+			break;
+		}
+		if (n > 0) {
+			if (c != ',') {
+				return c == '\0' ? JSMN_ERROR_PART : JSMN_ERROR_INVAL;
+			}
+			s->parser.pos++;
+			c = jsmn_select_peek(s);
+		}
+		if (c == '\0') {
+			return JSMN_ERROR_PART;
+		}
+
+		/* Which paths go on into the member or element */
+		next = 0;
+		if (close == ']') {
+			for (p = 0; p < s->num_paths; p++) {
+				step = &s->paths[p].steps[depth];
+				if ((alive >> p & 1) && (step->type == JSMN_STEP_ANY_ELEMENT ||
+							(step->type != JSMN_STEP_ANY_MEMBER &&
+							 step->index == (jsmnint_t)n))) {
+					next |= 1UL << p;
+				}
+			}
+			if ((r = jsmn_select_value(s, next, depth + 1, i)) < 0) {
+				return r;
+			}
+			continue;
+		}
+
+		key = s->parser.pos;
+#ifdef JSMN_STRICT
+		if (c != '\"') {
+			return JSMN_ERROR_INVAL;
+		}
+#endif
+		if ((r = jsmn_select_skip(s)) < 0) {
+			return r;
+		}
+		end = s->parser.pos;
+		if (s->js[key] == '\"') {
+			jsmn_tok_fill(&name, JSMN_STRING, key + 1, end - 1);
+		} else {
+			jsmn_tok_fill(&name, JSMN_PRIMITIVE, key, end);
+		}
+		for (p = 0; p < s->num_paths; p++) {
+			step = &s->paths[p].steps[depth];
+			if ((alive >> p & 1) && (step->type == JSMN_STEP_ANY_MEMBER ||
+						(step->type == JSMN_STEP_NAME &&
+						 jsmn_step_matches(&s->paths[p], step, s->js, &name)))) {
+				next |= 1UL << p;
+			}
+		}
+		if (jsmn_select_peek(s) != ':') {
+			return jsmn_select_peek(s) == '\0' ? JSMN_ERROR_PART :
+				JSMN_ERROR_INVAL;
+		}
+		s->parser.pos++;
+		c = jsmn_select_peek(s);
+		if (c == '\0') {
+			return JSMN_ERROR_PART;
+		}
+		if (next == 0 || jsmn_select_wants(s, next, depth + 1, c) == 0) {
+			if ((r = jsmn_select_skip(s)) < 0) {
+				return r;
+			}
+			continue;
+		}
+		/* Kept: its key gets a token first */
+		end = s->parser.pos;
+		s->parser.pos = key;
+		if ((r = jsmn_select_scalar(s, i)) < 0) {
+			return r;
+		}
+		s->parser.pos = end;
+		if ((r = jsmn_select_value(s, next, depth + 1,
+						s->parser.toknext - 1)) < 0) {
+			return r;
+		}
+	}
+
+	/* Close it */
+	token = &s->tokens[i];
+	jsmn_tok_close(token, s->parser.pos + 1, s->parser.toknext - i);
+	s->parser.pos++;
+	return 0;
+}
+
+jsmnint_t jsmn_parse_select(const char *js, size_t len,
+		const jsmnpath_t *paths, jsmnuint_t num_paths,
+		jsmntok_t *tokens, jsmnuint_t num_tokens) {
+	jsmn_selector s;
+	unsigned long alive;
+	int r;
+
+	if (num_paths > JSMN_SELECT_PATHS) {
+		return JSMN_ERROR_INVAL;
+	}
+	alive = num_paths == JSMN_SELECT_PATHS ? 0xFFFFFFFFUL :
+		(1UL << num_paths) - 1;
+	jsmn_init(&s.parser);
+	s.js = js;
+	s.len = len;
+	s.tokens = tokens;
+	s.num_tokens = num_tokens;
+	s.paths = paths;
+	s.num_paths = num_paths;
+	while (jsmn_select_peek(&s) != '\0') {
+		if ((r = jsmn_select_value(&s, alive, 0, -1)) < 0) {
+			return r;
+		}
+	}
+	return s.parser.toknext;
+}
+
 /**
  * Creates a new parser based over a given  buffer with an array of tokens
  * available.
@@ -310,5 +1740,8 @@ void jsmn_init(jsmn_parser *parser) {
 	parser->pos = 0;
 	parser->toknext = 0;
 	parser->toksuper = -1;
+	parser->depth = 0;
+	parser->state = 0;
+	parser->tokstart = 0;
 }
 
@@ -22,15 +22,79 @@ typedef enum {
 	JSMN_PRIMITIVE = 4
 } jsmntype_t;
 
+/**
+ * Offsets, sizes and token indexes. With JSMN_LARGE they are as wide as
+ * size_t, for documents of 2 GiB and more.
+ */
+#ifdef JSMN_LARGE
+#ifdef JSMN_PACKED
+#error "JSMN_PACKED cannot be combined with JSMN_LARGE"
+#endif
+typedef ptrdiff_t jsmnint_t;
+typedef size_t jsmnuint_t;
+#else
+typedef int jsmnint_t;
+typedef unsigned int jsmnuint_t;
+#endif
+
 enum jsmnerr {
 	/* Not enough tokens were provided */
 	JSMN_ERROR_NOMEM = -1,
 	/* Invalid character inside JSON string */
 	JSMN_ERROR_INVAL = -2,
 	/* The string is not a full JSON packet, more bytes expected */
-	JSMN_ERROR_PART = -3
+	JSMN_ERROR_PART = -3,
+	/* The file cannot be opened or mapped (jsmn_parse_file), errno tells why */
+	JSMN_ERROR_FILE = -4,
+	/* A number does not fit the type it is read as (jsmn_number.h) */
+	JSMN_ERROR_RANGE = -5,
+	/* Malformed UTF-8 inside JSON string (JSMN_UTF8 builds only) */
+	JSMN_ERROR_UTF8 = -6
 };
 
+#ifdef JSMN_PACKED
+/**
+ * Packed JSON token, 8 bytes instead of 16.
+ * start	start position in JSON data string
+ * info		bits 0-2: type; bits 4-31: length of a string or primitive, or
+ * 		number of children of an object or array (whose end position
+ * 		is not kept); bit 3: set on a key that has a value, and on an
+ * 		object or array that is not closed yet. A key followed by
+ * 		several values, which only the lenient grammar accepts,
+ * 		still reads as size 1.
+ */
+typedef struct {
+	unsigned int start;
+	unsigned int info;
+#ifdef JSMN_SPANS
+	int span;
+#endif
+} jsmnplaintok_t;
+
+/**
+ * The same with parent, the index of the parent token or -1.
+ */
+typedef struct {
+	unsigned int start;
+	unsigned int info;
+	int parent;
+#ifdef JSMN_SPANS
+	int span;
+#endif
+} jsmnlinktok_t;
+
+/**
+ * Token accessors, the same for both layouts. In the packed one the end of an
+ * object or array reads as -1, and the size of a string as 0 or 1 however
+ * many values follow a key.
+ */
+#define jsmn_tok_type(t) ((jsmntype_t)((t)->info & 7))
+#define jsmn_tok_start(t) ((int)(t)->start)
+#define jsmn_tok_end(t) (jsmn_tok_type(t) >= JSMN_STRING ? \
+		(int)((t)->start + ((t)->info >> 4)) : -1)
+#define jsmn_tok_size(t) (jsmn_tok_type(t) >= JSMN_STRING ? \
+		(int)((t)->info >> 3 & 1) : (int)((t)->info >> 4))
+#else
 /**
  * JSON token description.
  * type		type (object, array, string etc.)
@@ -39,22 +103,80 @@ enum jsmnerr {
  */
 typedef struct {
 	jsmntype_t type;
-	int start;
-	int end;
-	int size;
+	jsmnint_t start;
+	jsmnint_t end;
+	jsmnint_t size;
+#ifdef JSMN_SPANS
+	jsmnint_t span;
+#endif
+} jsmnplaintok_t;
+
+/**
+ * The same with parent, the index of the parent token or -1.
+ */
+typedef struct {
+	jsmntype_t type;
+	jsmnint_t start;
+	jsmnint_t end;
+	jsmnint_t size;
+	jsmnint_t parent;
+#ifdef JSMN_SPANS
+	jsmnint_t span;
+#endif
+} jsmnlinktok_t;
+
+#define jsmn_tok_type(t) ((t)->type)
+#define jsmn_tok_start(t) ((t)->start)
+#define jsmn_tok_end(t) ((t)->end)
+#define jsmn_tok_size(t) ((t)->size)
+#endif
+
+/**
+ * The token of jsmn_parse() and of every other function below but the named
+ * parser variants: a linked one with JSMN_PARENT_LINKS, a plain one without.
+ */
 #ifdef JSMN_PARENT_LINKS
-	int parent;
+typedef jsmnlinktok_t jsmntok_t;
+#else
+typedef jsmnplaintok_t jsmntok_t;
+#endif
+
+/**
+ * With JSMN_SPANS, every token also gets the number of tokens its value takes,
+ * itself included: 1 for a string or primitive (a key does not count its
+ * value), and for an object or array, set when it is closed (0 until then),
+ * 1 plus all its descendants. The next sibling of a value is then found
+ * without counting children.
+ */
+#ifdef JSMN_SPANS
+#define jsmn_tok_span(t) ((t)->span)
+#endif
+
+/**
+ * Nesting depth up to which open objects and arrays are tracked on the
+ * parser's own stack. With linked tokens, deeper containers are found by
+ * following the links and parsing stays linear at any depth. Without them,
+ * each comma and closing bracket deeper than this scans back over the tokens
+ * since the container was opened, so a wide array nested below this depth is
+ * quadratic again. Define a larger JSMN_MAX_DEPTH, or use linked tokens, for
+ * such documents.
+ */
+#ifndef JSMN_MAX_DEPTH
+#define JSMN_MAX_DEPTH 32
 #endif
-} jsmntok_t;
 
 /**
  * JSON parser. Contains an array of token blocks available. Also stores
  * the string being parsed now and current position in that string
  */
 typedef struct {
-	unsigned int pos; /* offset in the JSON string */
-	unsigned int toknext; /* next token to allocate */
-	int toksuper; /* superior token node, e.g parent object or array */
+	jsmnuint_t pos; /* offset in the JSON string */
+	jsmnuint_t toknext; /* next token to allocate */
+	jsmnint_t toksuper; /* superior token node, e.g parent object or array */
+	int state; /* lexer state of a string or primitive cut by end of input */
+	jsmnuint_t tokstart; /* ... and its start offset */
+	jsmnuint_t depth; /* number of objects and arrays not closed yet */
+	jsmnint_t stack[JSMN_MAX_DEPTH]; /* their token indexes, innermost last */
 } jsmn_parser;
 
 /**
@@ -66,8 +188,282 @@ void jsmn_init(jsmn_parser *parser);
  * Run JSON parser. It parses a JSON data string into and array of tokens, each describing
  * a single JSON object.
  */
-int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
-		jsmntok_t *tokens, unsigned int num_tokens);
+jsmnint_t jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
+		jsmntok_t *tokens, jsmnuint_t num_tokens);
+
+/**
+ * jsmn_parse() with the grammar and the token layout fixed regardless of
+ * JSMN_STRICT and JSMN_PARENT_LINKS: strict JSON or the lenient grammar with
+ * unquoted values and keys, into plain tokens or into tokens linked to their
+ * parents. All four are always built, so one program can use any of them.
+ * Keep to one of them per jsmn_parser.
+ */
+jsmnint_t jsmn_parse_strict(jsmn_parser *parser, const char *js, size_t len,
+		jsmnplaintok_t *tokens, jsmnuint_t num_tokens);
+jsmnint_t jsmn_parse_lenient(jsmn_parser *parser, const char *js, size_t len,
+		jsmnplaintok_t *tokens, jsmnuint_t num_tokens);
+jsmnint_t jsmn_parse_strict_links(jsmn_parser *parser, const char *js,
+		size_t len, jsmnlinktok_t *tokens, jsmnuint_t num_tokens);
+jsmnint_t jsmn_parse_lenient_links(jsmn_parser *parser, const char *js,
+		size_t len, jsmnlinktok_t *tokens, jsmnuint_t num_tokens);
+
+/**
+ * Check a complete JSON string without storing any tokens. Returns the exact
+ * number of tokens jsmn_parse() needs for it, or the error jsmn_parse() would
+ * return, with brackets matched as in a full parse (unlike jsmn_parse() with
+ * a NULL token array). Nesting deeper than JSMN_MAX_DEPTH * 32 levels is
+ * reported as JSMN_ERROR_NOMEM. With both JSMN_STRICT and JSMN_PARENT_LINKS,
+ * input with ':' outside of objects may be judged differently.
+ */
+jsmnint_t jsmn_validate(const char *js, size_t len);
+
+/**
+ * Events reported by jsmn_parse_events().
+ */
+typedef enum {
+	JSMN_EVENT_BEGIN_OBJECT = 1,
+	JSMN_EVENT_END_OBJECT = 2,
+	JSMN_EVENT_BEGIN_ARRAY = 3,
+	JSMN_EVENT_END_ARRAY = 4,
+	JSMN_EVENT_KEY = 5,
+	JSMN_EVENT_STRING = 6,
+	JSMN_EVENT_PRIMITIVE = 7
+} jsmnevent_t;
+
+/**
+ * Callback of jsmn_parse_events(). start and end delimit the value as in a
+ * token (for brackets, the bracket itself) and depth is the number of objects
+ * and arrays around it. Returning non-zero stops the parser, which then
+ * returns that value.
+ */
+typedef int (*jsmn_callback_t)(jsmnevent_t event, jsmnint_t start,
+		jsmnint_t end, jsmnuint_t depth, void *data);
+
+/**
+ * Parse a complete JSON string without any tokens, calling back for every
+ * bracket and value as it is found; memory use does not depend on the size
+ * of the input. A string is reported as a key when it comes first in an
+ * object or right after a comma in one. Returns what jsmn_validate() returns,
+ * unless the callback stops the parser earlier; what comes before an error
+ * has already been reported.
+ */
+jsmnint_t jsmn_parse_events(const char *js, size_t len,
+		jsmn_callback_t callback, void *data);
+
+/**
+ * One record found by jsmn_parse_records(): its tokens are tokens[first] to
+ * tokens[first + count - 1].
+ */
+typedef struct {
+	jsmnuint_t first;
+	jsmnuint_t count;
+} jsmnrecord_t;
+
+/**
+ * Parse a buffer of concatenated JSON values, e.g. NDJSON / JSON Lines, in a
+ * single pass. Every top-level value is a record; the tokens of all records
+ * go to the same array, from index 0 on every call, and their ranges to
+ * records. Returns the number of complete records and stores in *used the
+ * offset where the first record not returned starts: one cut by the end of
+ * the buffer (a primitive is only complete once followed by a delimiter,
+ * such as its newline), or that did not fit into tokens or records, or that
+ * is malformed. Move the bytes from there to the front of the buffer, append
+ * more input and call again. An error is only returned when it concerns the
+ * first record (JSMN_ERROR_NOMEM if it needs more tokens); JSMN_ERROR_PART
+ * is never returned, a cut first record just gives 0.
+ */
+jsmnint_t jsmn_parse_records(const char *js, size_t len,
+		jsmntok_t *tokens, jsmnuint_t num_tokens,
+		jsmnrecord_t *records, jsmnuint_t num_records, size_t *used);
+
+/**
+ * Allocator used by jsmn_parse_grow(). Works like realloc(): returns ptr
+ * resized to size bytes (ptr may be NULL), or NULL if that is not possible,
+ * in which case ptr must be left untouched.
+ */
+typedef void *(*jsmn_realloc_t)(void *ptr, size_t size, void *data);
+
+/**
+ * Run JSON parser with a token array that grows as needed. *tokens and
+ * *num_tokens describe the current array (NULL and 0 to start empty); when
+ * it runs out, its size is doubled through realloc_fn and parsing goes on
+ * from where it stopped, so the document is still parsed in a single pass.
+ * On return they describe the (possibly moved) array, which belongs to the
+ * caller. JSMN_ERROR_NOMEM is only returned if realloc_fn fails.
+ */
+jsmnint_t jsmn_parse_grow(jsmn_parser *parser, const char *js, size_t len,
+		jsmntok_t **tokens, jsmnuint_t *num_tokens,
+		jsmn_realloc_t realloc_fn, void *data);
+
+/**
+ * Slot of a key index: a key token and the object it belongs to. Free slots
+ * have key 0.
+ */
+typedef struct {
+	jsmnint_t object;
+	jsmnint_t key;
+} jsmnslot_t;
+
+/**
+ * Hash table of the keys of every object of a token array, with open
+ * addressing and linear probing. size is a power of two.
+ */
+typedef struct {
+	jsmnslot_t *slots;
+	jsmnuint_t size;
+} jsmnkeyindex_t;
+
+/**
+ * Returns the number of slots to give jsmn_build_key_index() for tokens:
+ * twice the number of keys, rounded up to a power of two.
+ */
+jsmnuint_t jsmn_key_index_size(const jsmntok_t *tokens, jsmnuint_t num_tokens);
+
+/**
+ * Index the keys of every object of a parsed token array into index->slots,
+ * whose size must come from jsmn_key_index_size(). Returns the number of
+ * keys, or JSMN_ERROR_NOMEM if the slots are too few.
+ */
+jsmnint_t jsmn_build_key_index(jsmnkeyindex_t *index, const char *js,
+		const jsmntok_t *tokens, jsmnuint_t num_tokens);
+
+/**
+ * Look a key up in the object at tokens[obj] in O(1) on average, comparing
+ * it with the key as it is written in js (escapes are not decoded). Returns
+ * the index of its value, of the first one if the key is repeated, or -1.
+ */
+jsmnint_t jsmn_lookup(const jsmnkeyindex_t *index, const char *js,
+		const jsmntok_t *tokens, jsmnint_t obj, const char *key);
+
+/**
+ * Cursor over a parsed token array. It keeps the indexes of the tokens above
+ * the current one and how many siblings follow at each level, so that moving
+ * to the first child, the next sibling or the parent takes O(1), the next
+ * sibling only with JSMN_SPANS (without, the tokens of the current value are
+ * counted). The children of an object are
+ * its keys, and the child of a key is its value. Above JSMN_MAX_DEPTH levels
+ * parents are found through the parent links or by scanning the tokens.
+ */
+typedef struct {
+	const jsmntok_t *tokens;
+	jsmnuint_t num_tokens;
+	jsmnint_t pos; /* current token */
+	jsmnuint_t depth; /* number of tokens above it */
+	jsmnint_t stack[JSMN_MAX_DEPTH]; /* their indexes, innermost last */
+	jsmnuint_t left[JSMN_MAX_DEPTH]; /* siblings after the one on the way down */
+} jsmncursor_t;
+
+/**
+ * Put a cursor on the first token. Top-level values are siblings.
+ */
+void jsmn_cursor_init(jsmncursor_t *cursor, const jsmntok_t *tokens,
+		jsmnuint_t num_tokens);
+
+/**
+ * Move to the first child of the current token, to its next sibling or to
+ * its parent. Returns the index of the new current token, or -1 (and the
+ * cursor stays) if there is none.
+ */
+jsmnint_t jsmn_cursor_first_child(jsmncursor_t *cursor);
+jsmnint_t jsmn_cursor_next_sibling(jsmncursor_t *cursor);
+jsmnint_t jsmn_cursor_parent(jsmncursor_t *cursor);
+
+/**
+ * Steps of a compiled path:
+ * 	o Name: the member of an object with that name, or, for a JSON Pointer
+ * 	  step that is an array index, that element of an array
+ * 	o Index: an element of an array
+ * 	o Any member / any element: every value of an object / array
+ */
+typedef enum {
+	JSMN_STEP_NAME = 1,
+	JSMN_STEP_INDEX = 2,
+	JSMN_STEP_ANY_MEMBER = 3,
+	JSMN_STEP_ANY_ELEMENT = 4
+} jsmnsteptype_t;
+
+typedef struct {
+	jsmnsteptype_t type;
+	int tilde; /* the name has ~0 and ~1 escapes */
+	jsmnuint_t start; /* offset of the name in the expression */
+	jsmnuint_t len; /* ... and its length */
+	jsmnint_t index; /* array index, or -1 */
+} jsmnstep_t;
+
+/**
+ * Maximum number of steps of a path.
+ */
+#ifndef JSMN_PATH_STEPS
+#define JSMN_PATH_STEPS 16
+#endif
+
+/**
+ * Compiled path. Names are read from the expression, which must outlive it.
+ */
+typedef struct {
+	const char *expr;
+	jsmnuint_t num_steps;
+	jsmnstep_t steps[JSMN_PATH_STEPS];
+} jsmnpath_t;
+
+/**
+ * Compile a null-terminated path expression, either a JSON Pointer (RFC
+ * 6901: "" or "/a/0/m~1n") or a path: "$" followed by ".name", ".*",
+ * "[0]", "[*]" and "['name']" steps. Returns the number of steps,
+ * JSMN_ERROR_INVAL if the expression is malformed, or JSMN_ERROR_NOMEM if it
+ * has more than JSMN_PATH_STEPS steps.
+ */
+jsmnint_t jsmn_path_compile(jsmnpath_t *path, const char *expr);
+
+/**
+ * Evaluate a compiled path against a parsed token array, from tokens[0].
+ * Names are compared with keys with their escapes decoded; a repeated key
+ * only matches the first time. Objects and arrays that cannot match are
+ * skipped without visiting their children, in O(1) with JSMN_SPANS. Stores
+ * the indexes of the matching values in document order and returns how many
+ * there are, stopping once num_matches are found. With matches NULL, all of
+ * them are counted.
+ */
+jsmnint_t jsmn_path_eval(const jsmnpath_t *path, const char *js,
+		const jsmntok_t *tokens, jsmnuint_t num_tokens,
+		jsmnint_t *matches, jsmnuint_t num_matches);
+
+/**
+ * Maximum number of paths of jsmn_parse_select().
+ */
+#define JSMN_SELECT_PATHS 32
+
+/**
+ * Parse a complete JSON string, keeping only the values selected by compiled
+ * paths (see jsmn_path_compile()). A selected value gets all its tokens, as
+ * from jsmn_parse(); the objects and arrays on the way to it get a token
+ * whose size counts only the members and elements kept, and the keys of the
+ * members kept get one too. Everything else is skipped keeping track of
+ * nothing but nesting depth and string state, so it is neither checked nor
+ * given tokens. Evaluating the paths on the result finds the same values as
+ * on a full parse. Returns the number of tokens, or an error as jsmn_parse()
+ * does, or JSMN_ERROR_INVAL with more than JSMN_SELECT_PATHS paths.
+ */
+jsmnint_t jsmn_parse_select(const char *js, size_t len,
+		const jsmnpath_t *paths, jsmnuint_t num_paths,
+		jsmntok_t *tokens, jsmnuint_t num_tokens);
+
+/**
+ * Number of bytes the string token t takes once its escapes are decoded by
+ * jsmn_unescape(), so that a buffer can be sized exactly beforehand. Returns
+ * JSMN_ERROR_INVAL for an object or array token.
+ */
+jsmnint_t jsmn_unescaped_length(const char *js, const jsmntok_t *t);
+
+/**
+ * Decode the escapes of the string token t into buf as UTF-8, "\uXXXX"
+ * surrogate pairs included; an unpaired surrogate becomes U+FFFD. No null
+ * terminator is added. Returns the number of bytes stored, JSMN_ERROR_NOMEM
+ * if they are more than size (what fits may have been stored), or
+ * JSMN_ERROR_INVAL for an object or array token.
+ */
+jsmnint_t jsmn_unescape(const char *js, const jsmntok_t *t, char *buf,
+		size_t size);
 
 #ifdef __cplusplus
 }
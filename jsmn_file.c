@@ -0,0 +1,95 @@
+#include "jsmn_file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define JSMN_MMAP
+#endif
+
+#ifdef JSMN_MMAP
+/**
+ * Maps the file read-only and tells the kernel it will be read front to back,
+ * so that it reads ahead aggressively and drops pages already parsed.
+ */
+const char *jsmn_map_file(const char *path, size_t *len) {
+	struct stat st;
+	void *map;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return NULL;
+	}
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		return NULL;
+	}
+	*len = (size_t)st.st_size;
+	if (*len == 0) {
+		/* mmap() refuses empty mappings */
+		close(fd);
+		return "";
+	}
+	map = mmap(NULL, *len, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		return NULL;
+	}
+	madvise(map, *len, MADV_SEQUENTIAL);
+	return (const char *)map;
+}
+
+void jsmn_unmap_file(const char *js, size_t len) {
+	if (js != NULL && len > 0) {
+		munmap((void *)js, len);
+	}
+}
+#else
+/**
+ * Reads the whole file into memory.
+ */
+const char *jsmn_map_file(const char *path, size_t *len) {
+	FILE *f = fopen(path, "rb");
+	char *js;
+	long size;
+
+	if (f == NULL) {
+		return NULL;
+	}
+	if (fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0 ||
+			fseek(f, 0, SEEK_SET) != 0) {
+		fclose(f);
+		return NULL;
+	}
+	js = (char *)malloc(size > 0 ? (size_t)size : 1);
+	if (js == NULL) {
+		fclose(f);
+		return NULL;
+	}
+	*len = fread(js, 1, (size_t)size, f);
+	fclose(f);
+	return js;
+}
+
+void jsmn_unmap_file(const char *js, size_t len) {
+	(void)len;
+	free((void *)js);
+}
+#endif
+
+jsmnint_t jsmn_parse_file(jsmn_parser *parser, const char *path,
+		const char **js, size_t *len,
+		jsmntok_t **tokens, jsmnuint_t *num_tokens,
+		jsmn_realloc_t realloc_fn, void *data) {
+	*js = jsmn_map_file(path, len);
+	if (*js == NULL) {
+		return JSMN_ERROR_FILE;
+	}
+	return jsmn_parse_grow(parser, *js, *len, tokens, num_tokens,
+			realloc_fn, data);
+}
@@ -0,0 +1,39 @@
+#ifndef __JSMN_FILE_H_
+#define __JSMN_FILE_H_
+
+#include "jsmn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Map a whole file read-only (read it into memory where mmap() is not
+ * available). Returns its contents and stores their length in *len, or
+ * returns NULL and sets errno. The contents are not NUL-terminated.
+ */
+const char *jsmn_map_file(const char *path, size_t *len);
+
+/**
+ * Release contents returned by jsmn_map_file().
+ */
+void jsmn_unmap_file(const char *js, size_t len);
+
+/**
+ * Parse a file in place: it is mapped with jsmn_map_file() and parsed with
+ * jsmn_parse_grow(), so the tokens point straight into the mapping and no
+ * copy of the input is made. *js and *len receive the mapping, which the
+ * caller releases with jsmn_unmap_file() after use, whatever the result.
+ * Returns JSMN_ERROR_FILE, with *js NULL and errno telling why, when the
+ * file cannot be opened or mapped.
+ */
+jsmnint_t jsmn_parse_file(jsmn_parser *parser, const char *path,
+		const char **js, size_t *len,
+		jsmntok_t **tokens, jsmnuint_t *num_tokens,
+		jsmn_realloc_t realloc_fn, void *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __JSMN_FILE_H_ */
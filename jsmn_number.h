@@ -0,0 +1,34 @@
+#ifndef __JSMN_NUMBER_H_
+#define __JSMN_NUMBER_H_
+
+#include <stdint.h>
+
+#include "jsmn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Read the primitive token t as an integer. Returns 0, JSMN_ERROR_INVAL if it
+ * is not a JSON number without fraction and exponent (a token of another
+ * type included), or JSMN_ERROR_RANGE if it does not fit, in which case
+ * *value is left untouched.
+ */
+jsmnint_t jsmn_get_int64(const char *js, const jsmntok_t *t, int64_t *value);
+jsmnint_t jsmn_get_uint64(const char *js, const jsmntok_t *t, uint64_t *value);
+
+/**
+ * Read the primitive token t as a double, correctly rounded to nearest, ties
+ * to even, whatever the number of digits; does not depend on the locale.
+ * Returns 0, JSMN_ERROR_INVAL if it is not a JSON number, or
+ * JSMN_ERROR_RANGE if its magnitude is too large, when *value is set to an
+ * infinity of its sign.
+ */
+jsmnint_t jsmn_get_double(const char *js, const jsmntok_t *t, double *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __JSMN_NUMBER_H_ */
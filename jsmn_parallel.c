@@ -0,0 +1,650 @@
+#include "jsmn_parallel.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Fewest bytes per thread worth the extra passes over the input.
+ */
+#ifndef JSMN_PARALLEL_MIN
+#define JSMN_PARALLEL_MIN (256 * 1024)
+#endif
+
+#define JSMN_PARALLEL_MAX 64
+
+/**
+ * One thread's share of the input. The pre-scan runs over [begin, end), which
+ * never starts right after a backslash; the elements tokenized are those in
+ * [from, to), from and to being the first element boundaries at or after
+ * this range's begin and the next one's.
+ */
+typedef struct {
+	const char *js;
+	size_t len;
+	size_t open; /* offset of the bracket opening the array */
+	size_t close; /* ... and of the one closing it, the last byte of input */
+	size_t begin, end;
+	/* Pre-scan: parity of the quotes, and how deep the range leaves the
+	 * nesting if it starts outside a string, or inside one; bit 0 of bad is
+	 * set when the range cannot be cut starting outside, bit 1 inside */
+	int quotes;
+	jsmnint_t depth_out, depth_in;
+	int nul, bad;
+	/* State at begin, from the ranges before */
+	int in_string;
+	jsmnint_t depth;
+	const void *next;
+	/* Tokenizing */
+	size_t from, to;
+	jsmn_parser parser;
+	jsmntok_t *tokens;
+	jsmnuint_t num_tokens;
+	jsmnint_t r;
+	/* Joining */
+	jsmntok_t *dest;
+	jsmnuint_t base;
+} jsmn_range;
+
+/**
+ * Whether the byte before offset i, taken to be outside a string, belongs to
+ * a primitive. jsmn_parse() would then read a quote, bracket or backslash at
+ * i as part of that primitive too.
+ */
+static int jsmn_after_primitive(const char *js, size_t i) {
+#ifdef JSMN_STRICT
+	/* Only a lenient primitive ends at a colon */
+	while (i > 0 && js[i - 1] == ':') {
+		i--;
+	}
+#endif
+	return i > 0 && strchr(" \t\r\n,:[]{}\"", js[i - 1]) == NULL;
+}
+
+static void *jsmn_prescan(void *arg) {
+	jsmn_range *range = (jsmn_range *)arg;
+	const char *js = range->js;
+	size_t i;
+	int in = 0;
+
+	/* in is the string state had the range started outside a string; had it
+	 * started inside one, the state is the opposite. Whichever of the two
+	 * is outside a string at a quote, bracket or backslash that jsmn_parse()
+	 * would read as part of a primitive is marked bad */
+	for (i = range->begin; i < range->end; i++) {
+		switch (js[i]) {
+			case '\\':
+				/* Only valid in a string: outside one it is read as part
+				 * of a primitive */
+				range->bad |= 1 << in;
+				i++;
+				break;
+			case '"':
+				if (jsmn_after_primitive(js, i)) {
+					range->bad |= 1 << in;
+				}
+				in = !in;
+				break;
+			case '{': case '[':
+				if (jsmn_after_primitive(js, i)) {
+					range->bad |= 1 << in;
+				}
+				if (in) range->depth_in++; else range->depth_out++;
+				break;
+			case '}': case ']':
+				if (in) range->depth_in--; else range->depth_out--;
+				break;
+			case '\0':
+				range->nul = 1;
+				break;
+		}
+	}
+	range->quotes = in;
+	return NULL;
+}
+
+/**
+ * Returns the offset just past the first comma between elements of the
+ * top-level array at or after the range's begin, or of the bracket closing
+ * the array, or the end of input.
+ */
+static size_t jsmn_boundary(const jsmn_range *range) {
+	const char *js = range->js;
+	jsmnint_t depth = range->depth;
+	int in = range->in_string;
+	size_t i;
+
+	for (i = range->begin; i < range->len; i++) {
+		if (in) {
+			if (js[i] == '\\') {
+				i++;
+			} else if (js[i] == '"') {
+				in = 0;
+			}
+			continue;
+		}
+		switch (js[i]) {
+			case '"':
+				in = 1;
+				break;
+			case '{': case '[':
+				depth++;
+				break;
+			case '}': case ']':
+				if (--depth == 0) {
+					return i;
+				}
+				break;
+			case ',':
+				if (depth == 1) {
+					return i + 1;
+				}
+				break;
+		}
+	}
+	return range->len;
+}
+
+static void *jsmn_realloc_tokens(void *ptr, size_t size, void *data) {
+	(void)data;
+	return realloc(ptr, size);
+}
+
+static void *jsmn_tokenize(void *arg) {
+	jsmn_range *range = (jsmn_range *)arg;
+
+	range->from = range->begin == 0 ? 0 : jsmn_boundary(range);
+	range->to = range->next == NULL ? range->close :
+		jsmn_boundary((const jsmn_range *)range->next);
+	if (range->from >= range->to) {
+		return NULL;
+	}
+	jsmn_init(&range->parser);
+	if (range->from == 0) {
+		range->r = jsmn_parse_grow(&range->parser, range->js, range->to,
+				&range->tokens, &range->num_tokens,
+				jsmn_realloc_tokens, NULL);
+		return NULL;
+	}
+	/* Open the array again as token 0 and go on from the range's first
+	 * element, as if everything before had been parsed */
+	range->r = jsmn_parse_grow(&range->parser, range->js, range->open + 1,
+			&range->tokens, &range->num_tokens, jsmn_realloc_tokens, NULL);
+	if (range->r != JSMN_ERROR_PART) {
+		return NULL;
+	}
+	range->parser.pos = range->from;
+	range->r = jsmn_parse_grow(&range->parser, range->js, range->to,
+			&range->tokens, &range->num_tokens, jsmn_realloc_tokens, NULL);
+	return NULL;
+}
+
+/**
+ * Copies the range's tokens to their place in the caller's array. Token 0,
+ * the array itself, is joined by the caller.
+ */
+static void *jsmn_join(void *arg) {
+	jsmn_range *range = (jsmn_range *)arg;
+	jsmnuint_t i, n = range->parser.toknext;
+
+	if (range->tokens == NULL) {
+		return NULL;
+	}
+	memcpy(range->dest, range->tokens + 1, (n - 1) * sizeof(jsmntok_t));
+#ifdef JSMN_PARENT_LINKS
+	for (i = 0; i < n - 1; i++) {
+		if (range->dest[i].parent > 0) {
+			range->dest[i].parent += range->base - 1;
+		}
+	}
+#else
+	(void)i;
+#endif
+	free(range->tokens);
+	range->tokens = NULL;
+	return NULL;
+}
+
+/**
+ * Runs fn over the ranges, the first one on the calling thread.
+ */
+static int jsmn_run(jsmn_range *ranges, unsigned int n, void *(*fn)(void *)) {
+	pthread_t threads[JSMN_PARALLEL_MAX];
+	int started[JSMN_PARALLEL_MAX];
+	unsigned int i;
+	int ok = 1;
+
+	for (i = 1; i < n; i++) {
+		started[i] = 0;
+		if (pthread_create(&threads[i], NULL, fn, &ranges[i]) == 0) {
+			started[i] = 1;
+		} else {
+			fn(&ranges[i]);
+		}
+	}
+	fn(&ranges[0]);
+	for (i = 1; i < n; i++) {
+		if (started[i]) {
+			ok &= pthread_join(threads[i], NULL) == 0;
+		}
+	}
+	return ok;
+}
+
+jsmnint_t jsmn_parse_parallel(jsmn_parser *parser, const char *js, size_t len,
+		jsmntok_t *tokens, jsmnuint_t num_tokens, unsigned int threads) {
+	jsmn_range ranges[JSMN_PARALLEL_MAX];
+	jsmnuint_t count, size;
+	unsigned int i, last;
+	size_t open, close, at;
+	int in;
+	jsmnint_t depth;
+
+	if (threads == 0) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = cpus > 0 ? (unsigned int)cpus : 1;
+	}
+	if (threads > len / JSMN_PARALLEL_MIN) {
+		threads = (unsigned int)(len / JSMN_PARALLEL_MIN);
+	}
+	if (threads > JSMN_PARALLEL_MAX) {
+		threads = JSMN_PARALLEL_MAX;
+	}
+	for (open = 0; open < len && strchr(" \t\r\n", js[open]) != NULL &&
+			js[open] != '\0'; open++);
+	for (close = len; close > open && strchr(" \t\r\n", js[close - 1]) != NULL &&
+			js[close - 1] != '\0'; close--);
+	/* The array must be the only value: every range is then parsed up to
+	 * its closing bracket, which is only seen once the ranges are joined */
+	if (threads < 2 || open == len || js[open] != '[' ||
+			close - 1 <= open || js[close - 1] != ']' || tokens == NULL ||
+			parser->pos != 0 || parser->toknext != 0) {
+		return jsmn_parse(parser, js, len, tokens, num_tokens);
+	}
+	close--;
+
+	/* Cut the input evenly, but never right after a backslash, so that no
+	 * escape straddles two ranges */
+	for (i = 0; i < threads; i++) {
+		jsmn_range *range = &ranges[i];
+		memset(range, 0, sizeof(*range));
+		range->js = js;
+		range->len = len;
+		range->open = open;
+		range->close = close;
+		range->begin = i == 0 ? 0 : len / threads * i;
+		if (i > 0 && range->begin < ranges[i - 1].begin) {
+			range->begin = ranges[i - 1].begin;
+		}
+		while (range->begin > 0 && range->begin < len &&
+				js[range->begin - 1] == '\\') {
+			range->begin++;
+		}
+		if (i > 0) {
+			ranges[i - 1].end = range->begin;
+		}
+	}
+	ranges[threads - 1].end = len;
+	if (!jsmn_run(ranges, threads, jsmn_prescan)) {
+		return jsmn_parse(parser, js, len, tokens, num_tokens);
+	}
+
+	/* The quote parity tells whether each range starts in a string */
+	in = 0;
+	depth = 0;
+	for (i = 0; i < threads; i++) {
+		if (ranges[i].nul || (ranges[i].bad & 1 << in)) {
+			return jsmn_parse(parser, js, len, tokens, num_tokens);
+		}
+		ranges[i].in_string = in;
+		ranges[i].depth = depth;
+		ranges[i].next = i + 1 < threads ? &ranges[i + 1] : NULL;
+		depth += in ? ranges[i].depth_in : ranges[i].depth_out;
+		in ^= ranges[i].quotes;
+	}
+
+	if (!jsmn_run(ranges, threads, jsmn_tokenize)) {
+		goto fallback;
+	}
+
+	/* Every range must stop between two elements of the array, token 0,
+	 * with nothing else open: had the array been closed on the way, what
+	 * follows would not be its elements. Each range must also start where
+	 * the one before stopped */
+	count = 1;
+	size = 0;
+	last = 0;
+	at = 0;
+	for (i = 0; i < threads; i++) {
+		jsmn_range *range = &ranges[i];
+		if (range->from > range->to ||
+				(range->from < range->to && range->from != at)) {
+			goto fallback;
+		}
+		if (range->tokens == NULL) {
+			if (range->r < 0) {
+				goto fallback;
+			}
+			continue;
+		}
+		if (range->r != JSMN_ERROR_PART || range->parser.depth != 1 ||
+				range->parser.stack[0] != 0 || range->parser.toksuper != 0 ||
+				range->parser.state != 0) {
+			goto fallback;
+		}
+		at = range->to;
+		range->base = count;
+		count += range->parser.toknext - 1;
+		size += jsmn_tok_size(&range->tokens[0]);
+		last = i;
+	}
+	if (count > num_tokens) {
+		goto fallback;
+	}
+
+	for (i = 0; i < threads; i++) {
+		ranges[i].dest = tokens + ranges[i].base;
+	}
+	/* The array, still open, with all the elements counted */
+	tokens[0] = ranges[last].tokens[0];
+#ifdef JSMN_PACKED
+	tokens[0].info = (tokens[0].info & 15) | (unsigned int)size << 4;
+#else
+	tokens[0].size = size;
+#endif
+	*parser = ranges[last].parser;
+	parser->toknext = count;
+	jsmn_run(ranges, threads, jsmn_join);
+	/* Close it, from where the last range stopped */
+	return jsmn_parse(parser, js, len, tokens, num_tokens);
+
+fallback:
+	for (i = 0; i < threads; i++) {
+		free(ranges[i].tokens);
+	}
+	return jsmn_parse(parser, js, len, tokens, num_tokens);
+}
+
+/**
+ * Tokens in each arena block, unless a document needs more.
+ */
+#ifndef JSMN_BLOCK_TOKENS
+#define JSMN_BLOCK_TOKENS 16384
+#endif
+
+typedef struct jsmn_block {
+	struct jsmn_block *next;
+	jsmnuint_t size, used;
+	jsmntok_t tokens[1];
+} jsmn_block;
+
+/**
+ * A thread of the pool. Its share of the batch is [range >> 32, range &
+ * 0xffffffff), taken from the front by the thread itself and from the back
+ * by others, both with compare-and-swap.
+ */
+typedef struct {
+	unsigned long long range;
+	struct jsmn_pool *pool;
+	jsmn_block *blocks, *cur;
+	size_t parsed;
+	unsigned int id;
+	pthread_t thread;
+	/* Keeps the ranges of two threads off the same cache line */
+	char pad[64];
+} jsmn_worker;
+
+struct jsmn_pool {
+	pthread_mutex_t lock;
+	pthread_cond_t start, done;
+	unsigned long batch; /* batches started */
+	unsigned int running; /* threads not done with the current one */
+	int quit;
+	jsmndoc_t *docs;
+	unsigned int threads;
+	jsmn_worker workers[JSMN_PARALLEL_MAX];
+};
+
+#define JSMN_RANGE(lo, hi) ((unsigned long long)(lo) << 32 | (hi))
+
+/**
+ * Returns a block after the current one with room for at least size tokens,
+ * reusing one left from an earlier batch when it is large enough.
+ */
+static jsmn_block *jsmn_next_block(jsmn_worker *worker, size_t size) {
+	jsmn_block *block = worker->cur == NULL ? worker->blocks : worker->cur->next;
+
+	if (size < JSMN_BLOCK_TOKENS) {
+		size = JSMN_BLOCK_TOKENS;
+	}
+	if (block == NULL || block->size < size) {
+		/* The count must fit a jsmnint_t, and the block's bytes a size_t */
+		if (size > ((jsmnuint_t)-1 >> 1) ||
+				size - 1 > ((size_t)-1 - sizeof(jsmn_block)) / sizeof(jsmntok_t)) {
+			return NULL;
+		}
+		block = (jsmn_block *)malloc(sizeof(jsmn_block) +
+				(size - 1) * sizeof(jsmntok_t));
+		if (block == NULL) {
+			return NULL;
+		}
+		block->size = (jsmnuint_t)size;
+		if (worker->cur == NULL) {
+			block->next = worker->blocks;
+			worker->blocks = block;
+		} else {
+			block->next = worker->cur->next;
+			worker->cur->next = block;
+		}
+	}
+	block->used = 0;
+	worker->cur = block;
+	return block;
+}
+
+static void jsmn_parse_doc(jsmn_worker *worker, jsmndoc_t *doc) {
+	jsmn_block *block = worker->cur, *next;
+	jsmn_parser parser;
+	jsmnint_t r;
+
+	jsmn_init(&parser);
+	for (;;) {
+		if (block == NULL) {
+			r = JSMN_ERROR_NOMEM;
+		} else {
+			r = jsmn_parse(&parser, doc->js, doc->len, block->tokens + block->used,
+					block->size - block->used);
+		}
+		if (r != JSMN_ERROR_NOMEM) {
+			break;
+		}
+		/* Carry the tokens so far over to a block twice their number */
+		next = jsmn_next_block(worker, (size_t)parser.toknext * 2);
+		if (next == NULL) {
+			break;
+		}
+		if (block != NULL) {
+			memcpy(next->tokens, block->tokens + block->used,
+					parser.toknext * sizeof(jsmntok_t));
+		}
+		block = next;
+	}
+	doc->r = r;
+	doc->tokens = NULL;
+	if (r >= 0) {
+		doc->tokens = block->tokens + block->used;
+		block->used += r;
+		worker->parsed++;
+	}
+}
+
+/**
+ * Moves the back half of another thread's share to this one's, which is
+ * empty. Returns 0 when there is nothing left anywhere.
+ */
+static int jsmn_steal(jsmn_worker *worker) {
+	jsmn_pool *pool = worker->pool;
+	unsigned int i;
+
+	for (i = 1; i < pool->threads; i++) {
+		jsmn_worker *victim = &pool->workers[(worker->id + i) % pool->threads];
+		unsigned long long range = __atomic_load_n(&victim->range, __ATOMIC_ACQUIRE);
+		unsigned int lo = (unsigned int)(range >> 32), hi = (unsigned int)range;
+
+		while (lo < hi) {
+			unsigned int mid = hi - (hi - lo + 1) / 2;
+			if (__atomic_compare_exchange_n(&victim->range, &range,
+						JSMN_RANGE(lo, mid), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+				__atomic_store_n(&worker->range, JSMN_RANGE(mid, hi), __ATOMIC_RELEASE);
+				return 1;
+			}
+			lo = (unsigned int)(range >> 32);
+			hi = (unsigned int)range;
+		}
+	}
+	return 0;
+}
+
+static void jsmn_work(jsmn_worker *worker) {
+	jsmndoc_t *docs = worker->pool->docs;
+
+	do {
+		unsigned long long range = __atomic_load_n(&worker->range, __ATOMIC_ACQUIRE);
+		unsigned int lo = (unsigned int)(range >> 32), hi = (unsigned int)range;
+
+		while (lo < hi) {
+			if (__atomic_compare_exchange_n(&worker->range, &range,
+						JSMN_RANGE(lo + 1, hi), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+				jsmn_parse_doc(worker, &docs[lo]);
+				range = JSMN_RANGE(lo + 1, hi);
+			}
+			lo = (unsigned int)(range >> 32);
+			hi = (unsigned int)range;
+		}
+	} while (jsmn_steal(worker));
+}
+
+static void *jsmn_pool_thread(void *arg) {
+	jsmn_worker *worker = (jsmn_worker *)arg;
+	jsmn_pool *pool = worker->pool;
+	unsigned long batch = 0;
+
+	for (;;) {
+		pthread_mutex_lock(&pool->lock);
+		while (pool->batch == batch && !pool->quit) {
+			pthread_cond_wait(&pool->start, &pool->lock);
+		}
+		if (pool->quit) {
+			pthread_mutex_unlock(&pool->lock);
+			return NULL;
+		}
+		batch = pool->batch;
+		pthread_mutex_unlock(&pool->lock);
+
+		jsmn_work(worker);
+
+		pthread_mutex_lock(&pool->lock);
+		if (--pool->running == 0) {
+			pthread_cond_signal(&pool->done);
+		}
+		pthread_mutex_unlock(&pool->lock);
+	}
+}
+
+jsmn_pool *jsmn_pool_new(unsigned int threads) {
+	jsmn_pool *pool = (jsmn_pool *)calloc(1, sizeof(jsmn_pool));
+	unsigned int i;
+
+	if (pool == NULL) {
+		return NULL;
+	}
+	if (threads == 0) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = cpus > 0 ? (unsigned int)cpus : 1;
+	}
+	if (threads > JSMN_PARALLEL_MAX) {
+		threads = JSMN_PARALLEL_MAX;
+	}
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->start, NULL);
+	pthread_cond_init(&pool->done, NULL);
+	pool->threads = 1;
+	pool->workers[0].pool = pool;
+	/* Thread 0 is the caller's; go on with fewer if some cannot start */
+	for (i = 1; i < threads; i++) {
+		pool->workers[i].pool = pool;
+		pool->workers[i].id = i;
+		if (pthread_create(&pool->workers[i].thread, NULL, jsmn_pool_thread,
+					&pool->workers[i]) != 0) {
+			break;
+		}
+		pool->threads++;
+	}
+	return pool;
+}
+
+void jsmn_pool_free(jsmn_pool *pool) {
+	unsigned int i;
+
+	if (pool == NULL) {
+		return;
+	}
+	pthread_mutex_lock(&pool->lock);
+	pool->quit = 1;
+	pthread_cond_broadcast(&pool->start);
+	pthread_mutex_unlock(&pool->lock);
+	for (i = 0; i < pool->threads; i++) {
+		jsmn_block *block = pool->workers[i].blocks, *next;
+		if (i > 0) {
+			pthread_join(pool->workers[i].thread, NULL);
+		}
+		for (; block != NULL; block = next) {
+			next = block->next;
+			free(block);
+		}
+	}
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->start);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool);
+}
+
+size_t jsmn_parse_batch(jsmn_pool *pool, jsmndoc_t *docs, size_t num_docs) {
+	size_t parsed = 0, n;
+	unsigned int i, threads = pool->threads;
+
+	for (i = 0; i < threads; i++) {
+		pool->workers[i].cur = NULL;
+		jsmn_next_block(&pool->workers[i], 0);
+	}
+	/* Shares are indexed with 32 bits, larger batches go in several rounds */
+	for (; num_docs > 0; docs += n, num_docs -= n) {
+		n = num_docs < 0xffffffffu ? num_docs : 0xffffffffu;
+		pool->docs = docs;
+		for (i = 0; i < threads; i++) {
+			pool->workers[i].range = JSMN_RANGE(
+					(unsigned long long)n * i / threads,
+					(unsigned long long)n * (i + 1) / threads);
+			pool->workers[i].parsed = 0;
+		}
+
+		pthread_mutex_lock(&pool->lock);
+		pool->running = threads - 1;
+		pool->batch++;
+		pthread_cond_broadcast(&pool->start);
+		pthread_mutex_unlock(&pool->lock);
+
+		jsmn_work(&pool->workers[0]);
+
+		pthread_mutex_lock(&pool->lock);
+		while (pool->running > 0) {
+			pthread_cond_wait(&pool->done, &pool->lock);
+		}
+		pthread_mutex_unlock(&pool->lock);
+		for (i = 0; i < threads; i++) {
+			parsed += pool->workers[i].parsed;
+		}
+	}
+	return parsed;
+}
@@ -0,0 +1,65 @@
+#ifndef __JSMN_PARALLEL_H_
+#define __JSMN_PARALLEL_H_
+
+#include "jsmn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Parse a document that is one big top-level array on several threads (0 for
+ * one per online CPU). The input is cut into ranges at commas between array
+ * elements, found after a parallel pre-scan that works out the string state
+ * and nesting depth at every cut; each thread tokenizes its range into a
+ * token segment of its own, and the segments are then joined. parser must
+ * be freshly initialized. Tokens, parser state and return value are the same
+ * as with jsmn_parse(); anything else than a single array, input too small
+ * to be worth splitting, primitives holding a quote, bracket or backslash,
+ * and input in error are handed to jsmn_parse() on the calling thread.
+ */
+jsmnint_t jsmn_parse_parallel(jsmn_parser *parser, const char *js, size_t len,
+		jsmntok_t *tokens, jsmnuint_t num_tokens, unsigned int threads);
+
+/**
+ * One document of a batch. js and len are set by the caller, r and tokens by
+ * jsmn_parse_batch().
+ */
+typedef struct {
+	const char *js;
+	size_t len;
+	jsmnint_t r; /* number of tokens, or the error from jsmn_parse() */
+	jsmntok_t *tokens; /* the r tokens, NULL on error */
+} jsmndoc_t;
+
+/**
+ * Pool of threads parsing batches of documents, each thread with a token
+ * arena of its own.
+ */
+typedef struct jsmn_pool jsmn_pool;
+
+/**
+ * Start a pool of threads (0 for one per online CPU), the calling thread
+ * being one of them. Returns NULL when out of memory.
+ */
+jsmn_pool *jsmn_pool_new(unsigned int threads);
+
+/**
+ * Stop the threads and release the arenas.
+ */
+void jsmn_pool_free(jsmn_pool *pool);
+
+/**
+ * Parse independent documents on the pool. Every thread starts on an equal
+ * share of the documents and, once done, steals half of what is left of
+ * another thread's share. The tokens are kept in the arenas until the next
+ * batch on the same pool. Returns the number of documents parsed without
+ * error.
+ */
+size_t jsmn_parse_batch(jsmn_pool *pool, jsmndoc_t *docs, size_t num_docs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __JSMN_PARALLEL_H_ */
@@ -2,9 +2,22 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+#if defined(JSMN_LARGE) && defined(__unix__)
+#include <sys/mman.h>
+#endif
 
 #include "test.h"
 #include "testutil.h"
+#include "../jsmn_file.c"
+#include "../jsmn_number.c"
+#if defined(__unix__) || defined(__APPLE__)
+/* Small ranges, so that short documents are split between threads too */
+#define JSMN_PARALLEL_MIN 16
+#include "../jsmn_parallel.c"
+#endif
 
 int test_empty(void) {
 	check(parse("{}", 1, 1,
@@ -365,6 +378,86 @@ int test_nonstrict(void) {
 	return 0;
 }
 
+/* Both grammars are built in every configuration */
+#define tok_same(a, b) (jsmn_tok_type(a) == jsmn_tok_type(b) && \
+		jsmn_tok_start(a) == jsmn_tok_start(b) && \
+		jsmn_tok_end(a) == jsmn_tok_end(b) && \
+		jsmn_tok_size(a) == jsmn_tok_size(b))
+
+int test_variants(void) {
+	static const char *docs[] = {
+		"{\"a\": [1, true, \"x\"]}", "{a: 1}", "Day : 26", "[1, :2]", "[1,"
+	};
+	static const jsmnint_t parents[] = { -1, 0, 1, 2, 2, 2 };
+	jsmntok_t t[8];
+	jsmnplaintok_t u[8];
+	jsmnlinktok_t v[8];
+	jsmn_parser p;
+	size_t i;
+
+	/* jsmn_parse() is the variant the build options select */
+	for (i = 0; i < sizeof(docs) / sizeof(docs[0]); i++) {
+		jsmnint_t r, q, l, j;
+		jsmn_init(&p);
+		r = jsmn_parse(&p, docs[i], strlen(docs[i]), t, 8);
+		jsmn_init(&p);
+#ifdef JSMN_STRICT
+		q = jsmn_parse_strict(&p, docs[i], strlen(docs[i]), u, 8);
+		jsmn_init(&p);
+		l = jsmn_parse_strict_links(&p, docs[i], strlen(docs[i]), v, 8);
+#else
+		q = jsmn_parse_lenient(&p, docs[i], strlen(docs[i]), u, 8);
+		jsmn_init(&p);
+		l = jsmn_parse_lenient_links(&p, docs[i], strlen(docs[i]), v, 8);
+#endif
+		check(r == q && r == l);
+		for (j = 0; j < r; j++) {
+			check(tok_same(&t[j], &u[j]) && tok_same(&t[j], &v[j]));
+#ifdef JSMN_PARENT_LINKS
+			check(t[j].parent == v[j].parent);
+#endif
+		}
+	}
+
+	jsmn_init(&p);
+	check(jsmn_parse_strict(&p, docs[0], strlen(docs[0]), u, 8) == 6);
+	jsmn_init(&p);
+	check(jsmn_parse_lenient(&p, docs[0], strlen(docs[0]), u, 8) == 6);
+	jsmn_init(&p);
+	check(jsmn_parse_strict(&p, docs[1], strlen(docs[1]), u, 8) == JSMN_ERROR_INVAL);
+	jsmn_init(&p);
+	check(jsmn_parse_lenient(&p, docs[1], strlen(docs[1]), u, 8) == 3);
+	check(jsmn_tok_type(&u[1]) == JSMN_PRIMITIVE && jsmn_tok_size(&u[1]) == 1);
+	jsmn_init(&p);
+	check(jsmn_parse_strict(&p, docs[2], strlen(docs[2]), u, 8) == JSMN_ERROR_INVAL);
+	jsmn_init(&p);
+	check(jsmn_parse_lenient(&p, docs[2], strlen(docs[2]), u, 8) == 2);
+	jsmn_init(&p);
+	check(jsmn_parse_strict(&p, docs[4], strlen(docs[4]), u, 8) == JSMN_ERROR_PART);
+	jsmn_init(&p);
+	check(jsmn_parse_lenient(&p, docs[4], strlen(docs[4]), u, 8) == JSMN_ERROR_PART);
+
+	/* The linked variants give the same tokens, with their parents */
+	for (i = 0; i < 2; i++) {
+		jsmnint_t j;
+		jsmn_init(&p);
+		check((i ? jsmn_parse_lenient_links : jsmn_parse_strict_links)(&p,
+					docs[0], strlen(docs[0]), v, 8) == 6);
+		jsmn_init(&p);
+		check((i ? jsmn_parse_lenient : jsmn_parse_strict)(&p,
+					docs[0], strlen(docs[0]), u, 8) == 6);
+		for (j = 0; j < 6; j++) {
+			check(tok_same(&u[j], &v[j]) && v[j].parent == parents[j]);
+		}
+	}
+	jsmn_init(&p);
+	check(jsmn_parse_strict_links(&p, docs[1], strlen(docs[1]), v, 8) == JSMN_ERROR_INVAL);
+	jsmn_init(&p);
+	check(jsmn_parse_lenient_links(&p, docs[1], strlen(docs[1]), v, 8) == 3);
+	check(v[1].parent == 0 && v[2].parent == 1);
+	return 0;
+}
+
 int test_unmatched_brackets(void) {
 	const char *js;
 	js = "\"key 1\": 1234}";
@@ -385,6 +478,1358 @@ int test_unmatched_brackets(void) {
 	return 0;
 }
 
+int test_whitespace_runs(void) {
+	int i, n;
+	char js[1024];
+	jsmntok_t tok[4];
+	jsmn_parser p;
+
+	/* Whitespace runs of every length across 64-byte block boundaries */
+	for (n = 0; n < 140; n++) {
+		i = 0;
+		js[i++] = '[';
+		memset(js + i, n % 2 ? ' ' : '\n', n); i += n;
+		js[i++] = '1';
+		memset(js + i, '\t', n); i += n;
+		js[i++] = ',';
+		memset(js + i, '\r', n); i += n;
+		memcpy(js + i, "\"a\"", 3); i += 3;
+		memset(js + i, ' ', n); i += n;
+		js[i++] = ',';
+		memset(js + i, ' ', n); i += n;
+		js[i++] = '{';
+		memset(js + i, '\n', n); i += n;
+		js[i++] = '}';
+		memset(js + i, ' ', n); i += n;
+		js[i++] = ']';
+		js[i] = '\0';
+
+		check(parse(js, 4, 4,
+					JSMN_ARRAY, 0, i, 3,
+					JSMN_PRIMITIVE, "1",
+					JSMN_STRING, "a", 0,
+					JSMN_OBJECT, i - 2 * n - 3, i - n - 1, 0));
+
+		/* Input ends in the middle of a whitespace run */
+		jsmn_init(&p);
+		check(jsmn_parse(&p, js, i - n / 2 - 1, tok, 4) == JSMN_ERROR_PART);
+	}
+
+	/* NUL byte inside a whitespace run terminates the input */
+	memset(js, ' ', 200);
+	js[0] = '[';
+	js[100] = '\0';
+	js[199] = ']';
+	jsmn_init(&p);
+	check(jsmn_parse(&p, js, 200, tok, 4) == JSMN_ERROR_PART);
+	check(p.pos == 100);
+	return 0;
+}
+
+int test_long_strings(void) {
+	int i, n;
+	char value[512];
+	char js[sizeof(value) + 16]; /* value plus the brackets around it */
+	jsmntok_t tok[3];
+	jsmn_parser p;
+
+	/* Escapes, quotes and control bytes at every offset of a long string */
+	for (n = 0; n < 200; n++) {
+		memset(value, 'x', 220);
+		memcpy(value + n, "\\\"\t\\u00e9\\\\", 11);
+		value[220] = '\0';
+		sprintf(js, "{\"k\":\"%s\"}", value);
+		check(parse(js, 3, 3,
+					JSMN_OBJECT, 0, (int)strlen(js), 1,
+					JSMN_STRING, "k", 1,
+					JSMN_STRING, value, 0));
+
+		/* Input ends inside the string body */
+		for (i = 6; i < (int)strlen(js) - 2; i += 37) {
+			jsmn_init(&p);
+			check(jsmn_parse(&p, js, i, tok, 3) == JSMN_ERROR_PART);
+		}
+	}
+
+	/* Invalid escape far from the string start */
+	memset(value, 'x', 100);
+	memcpy(value + 90, "\\q", 2);
+	value[100] = '\0';
+	sprintf(js, "[\"%s\"]", value);
+	check(parse(js, JSMN_ERROR_INVAL, 2));
+
+	/* NUL byte inside a string terminates the input */
+	memset(js, 'y', 100);
+	js[0] = '[';
+	js[1] = '\"';
+	js[70] = '\0';
+	js[98] = '\"';
+	js[99] = ']';
+	jsmn_init(&p);
+	check(jsmn_parse(&p, js, 100, tok, 3) == JSMN_ERROR_PART);
+	return 0;
+}
+
+int test_deep_nesting(void) {
+	int i, r;
+	char js[1024];
+	jsmntok_t tok[512];
+	jsmn_parser p;
+	const int depth = 3 * JSMN_MAX_DEPTH + 5;
+
+	/* {"a":[{"a":[ ... ]}]} nested well past the parser's stack */
+	memset(js, ' ', 10 * depth);
+	for (i = 0; i < depth; i++) {
+		memcpy(js + 5 * i, i % 2 ? "[    " : "{\"a\":", 5);
+		js[10 * depth - 5 * i] = i % 2 ? ']' : '}';
+	}
+	js[5 * depth] = '1';
+	js[10 * depth + 1] = '\0';
+	jsmn_init(&p);
+	r = jsmn_parse(&p, js, strlen(js), tok, 512);
+	check(r == depth + (depth + 1) / 2 + 1);
+	check(jsmn_tok_type(&tok[0]) == JSMN_OBJECT);
+#ifndef JSMN_PACKED
+	check(tok[0].end == 10 * depth + 1);
+#endif
+	check(jsmn_tok_type(&tok[r - 1]) == JSMN_PRIMITIVE &&
+			jsmn_tok_start(&tok[r - 1]) == 5 * depth);
+	for (i = 0; i < r - 1; i++) {
+		check(jsmn_tok_size(&tok[i]) == 1);
+	}
+
+	/* Mismatched bracket deep inside */
+	js[10 * depth - 5 * (depth / 2)] = depth / 2 % 2 ? '}' : ']';
+	check(parse(js, JSMN_ERROR_INVAL, 512));
+
+#ifdef JSMN_PARENT_LINKS
+	{
+		/* A wide array below the stack stays linear with parent links */
+		const int n = 200000;
+		char *wide = malloc(2 * depth + 2 * n + 1);
+		jsmntok_t *t = malloc((depth + n) * sizeof(jsmntok_t));
+		int k = 0;
+
+		for (i = 0; i < depth; i++) {
+			wide[k++] = '[';
+		}
+		for (i = 0; i < n; i++) {
+			wide[k++] = i ? ',' : '1';
+			if (i) {
+				wide[k++] = '1';
+			}
+		}
+		for (i = 0; i < depth; i++) {
+			wide[k++] = ']';
+		}
+		jsmn_init(&p);
+		check(jsmn_parse(&p, wide, k, t, depth + n) == depth + n);
+		check(jsmn_tok_size(&t[depth - 1]) == n);
+		free(t);
+		free(wide);
+	}
+#endif
+	return 0;
+}
+
+int test_wide_array(void) {
+	int i, r;
+	const int n = 200000;
+	char *js = malloc(n * 10 + 3);
+	jsmntok_t *tok = malloc((3 * n + 1) * sizeof(jsmntok_t));
+	jsmn_parser p;
+
+	/* Must parse in linear time, closing each object in O(1) */
+	js[0] = '[';
+	for (i = 0; i < n; i++) {
+		memcpy(js + 1 + 10 * i, "{\"a\": 12},", 10);
+	}
+	js[10 * n] = ']';
+	js[10 * n + 1] = '\0';
+	jsmn_init(&p);
+	r = jsmn_parse(&p, js, strlen(js), tok, 3 * n + 1);
+	check(r == 3 * n + 1);
+	check(jsmn_tok_size(&tok[0]) == n);
+#ifndef JSMN_PACKED
+	check(tok[0].end == 10 * n + 1);
+#endif
+	check(jsmn_tok_type(&tok[3 * n - 2]) == JSMN_OBJECT &&
+			jsmn_tok_size(&tok[3 * n - 2]) == 1);
+	free(js);
+	free(tok);
+	return 0;
+}
+
+int test_stream_chunks(void) {
+	int i, r, n;
+	char js[1024];
+	jsmntok_t tok[256], ref[256];
+	jsmn_parser p;
+
+	/* Nested past the parser stack, no primitives to be cut by a chunk end */
+	n = 0;
+	for (i = 0; i < 2 * JSMN_MAX_DEPTH; i++) {
+		n += sprintf(js + n, i % 2 ? "[\"s%d\", " : "{\"k%d\": ", i);
+	}
+	for (i = 2 * JSMN_MAX_DEPTH - 1; i >= 0; i--) {
+		n += sprintf(js + n, i % 2 ? ", {}]" : "}");
+	}
+	jsmn_init(&p);
+	memset(ref, 0, sizeof(ref));
+	r = jsmn_parse(&p, js, n, ref, 256);
+	check(r == 5 * JSMN_MAX_DEPTH);
+
+	for (i = 1; i <= 16; i += 5) {
+		int avail = 0;
+		jsmn_init(&p);
+		memset(tok, 0, sizeof(tok));
+		do {
+			avail = avail + i < n ? avail + i : n;
+			r = jsmn_parse(&p, js, avail, tok, 256);
+			check(avail == n || r == JSMN_ERROR_PART);
+		} while (avail < n);
+		check(r == 5 * JSMN_MAX_DEPTH);
+		check(memcmp(tok, ref, r * sizeof(jsmntok_t)) == 0);
+	}
+	return 0;
+}
+
+int test_partial_resume(void) {
+	int i, r;
+	jsmn_parser p;
+	jsmntok_t tok[4];
+#ifdef JSMN_STRICT
+	const char *js = "[\"ab\\\"c\\u12eF\\\\d\", 12345, \"x\"]";
+#else
+	/* A primitive cut by the end of input is complete in non-strict mode */
+	const char *js = "[\"ab\\\"c\\u12eF\\\\d\", \"12345\", \"x\"]";
+#endif
+
+	/* A cut string or primitive is resumed, not rescanned from its start */
+	jsmn_init(&p);
+	for (i = 1; i <= (int)strlen(js); i++) {
+		r = jsmn_parse(&p, js, i, tok, 4);
+		if (i == (int)strlen(js)) {
+			check(r == 4);
+			check(tokeq(js, tok, 4,
+						JSMN_ARRAY, 0, (int)strlen(js), 3,
+						JSMN_STRING, "ab\\\"c\\u12eF\\\\d", 0,
+#ifdef JSMN_STRICT
+						JSMN_PRIMITIVE, "12345",
+#else
+						JSMN_STRING, "12345", 0,
+#endif
+						JSMN_STRING, "x", 0));
+		} else {
+			check(r == JSMN_ERROR_PART);
+			check(p.pos == (unsigned int)i);
+		}
+	}
+
+	/* Bad hex digit arriving in a later chunk */
+	js = "[\"\\u12x4\"]";
+	jsmn_init(&p);
+	check(jsmn_parse(&p, js, 6, tok, 4) == JSMN_ERROR_PART);
+	check(jsmn_parse(&p, js, strlen(js), tok, 4) == JSMN_ERROR_INVAL);
+
+	/* Out of tokens at the closing quote: the retry only allocates */
+	js = "[\"abc\"]";
+	jsmn_init(&p);
+	check(jsmn_parse(&p, js, strlen(js), tok, 1) == JSMN_ERROR_NOMEM);
+	check(p.pos == 5);
+	check(jsmn_parse(&p, js, strlen(js), tok, 4) == 2);
+	check(tokeq(js, tok, 2,
+				JSMN_ARRAY, 0, 7, 1,
+				JSMN_STRING, "abc", 0));
+	return 0;
+}
+
+static int grow_calls = 0;
+
+static void *grow(void *ptr, size_t size, void *data) {
+	grow_calls++;
+	if (data != NULL && size > *(size_t *)data) {
+		return NULL;
+	}
+	return realloc(ptr, size);
+}
+
+int test_validate(void) {
+	static const char *docs[] = {
+		"{\"a\": [1, \"b\", {\"c\": null}], \"d\": {}}",
+		"[[], [[]], {\"a\": []}]",
+		"[1}", "{\"a\": 1]", "]", "[1, 2",
+		"{\"a\": \"b\" \"c\"}", "{\"a\": 1, \"b\"}", "{1: 2}",
+		"[\"a\": 1]", "{\"a\": {} \"b\"}", "[\"\\x\"]", "[\"ab",
+		"{\"a\": tru", "1 2 3", "\"a\":: \"b\"", "{\"a\"\n:\t[ 1 ,2 ] }"
+	};
+	jsmntok_t tok[32];
+	jsmn_parser p;
+	char js[3000];
+	unsigned int i;
+
+	for (i = 0; i < sizeof(docs) / sizeof(docs[0]); i++) {
+		jsmn_init(&p);
+		check(jsmn_validate(docs[i], strlen(docs[i])) ==
+				jsmn_parse(&p, docs[i], strlen(docs[i]), tok, 32));
+	}
+
+	/* Brackets are matched even though no tokens are stored */
+	jsmn_init(&p);
+	check(jsmn_parse(&p, "[1}", 3, NULL, 0) == 2);
+	check(jsmn_validate("[1}", 3) == JSMN_ERROR_INVAL);
+
+	/* One bit per level: far deeper than the parser stack */
+	for (i = 0; i < 1000; i++) {
+		js[i] = '[';
+		js[1999 - i] = ']';
+	}
+	check(jsmn_validate(js, 2000) == 1000);
+	js[1000] = '}';
+	check(jsmn_validate(js, 2000) == JSMN_ERROR_INVAL);
+	memset(js, '[', sizeof(js));
+	check(jsmn_validate(js, sizeof(js)) == JSMN_ERROR_NOMEM);
+	return 0;
+}
+
+#ifdef JSMN_PACKED
+int test_packed(void) {
+	const char *js = "{\"a\": [1, \"bc\"], \"d\": {}}";
+	jsmntok_t tok[8];
+	jsmn_parser p;
+	size_t expect = 8;
+
+#ifdef JSMN_PARENT_LINKS
+	expect += 4;
+#endif
+#ifdef JSMN_SPANS
+	expect += 4;
+#endif
+	check(sizeof(jsmntok_t) == expect);
+	jsmn_init(&p);
+	check(jsmn_parse(&p, js, strlen(js), tok, 8) == 7);
+	check(jsmn_tok_type(&tok[0]) == JSMN_OBJECT && jsmn_tok_start(&tok[0]) == 0 &&
+			jsmn_tok_end(&tok[0]) == -1 && jsmn_tok_size(&tok[0]) == 2);
+	check(jsmn_tok_type(&tok[1]) == JSMN_STRING && jsmn_tok_start(&tok[1]) == 2 &&
+			jsmn_tok_end(&tok[1]) == 3 && jsmn_tok_size(&tok[1]) == 1);
+	check(jsmn_tok_type(&tok[2]) == JSMN_ARRAY && jsmn_tok_size(&tok[2]) == 2);
+	check(jsmn_tok_type(&tok[4]) == JSMN_STRING && jsmn_tok_start(&tok[4]) == 11 &&
+			jsmn_tok_end(&tok[4]) == 13 && jsmn_tok_size(&tok[4]) == 0);
+	check(jsmn_tok_type(&tok[6]) == JSMN_OBJECT && jsmn_tok_start(&tok[6]) == 22 &&
+			jsmn_tok_size(&tok[6]) == 0);
+
+#ifndef JSMN_STRICT
+	/* The size of a key only tells that it has a value, not how many */
+	js = "{\"a\": 1 2 3, \"b\": 4}";
+	jsmn_init(&p);
+	check(jsmn_parse(&p, js, strlen(js), tok, 8) == 7);
+	check(jsmn_tok_type(&tok[1]) == JSMN_STRING && jsmn_tok_size(&tok[1]) == 1);
+	check(jsmn_tok_type(&tok[4]) == JSMN_PRIMITIVE && jsmn_tok_start(&tok[4]) == 10);
+	check(jsmn_tok_type(&tok[5]) == JSMN_STRING && jsmn_tok_size(&tok[5]) == 1);
+#endif
+
+	return 0;
+}
+#endif
+
+#if defined(JSMN_LARGE) && defined(__unix__)
+/*
+ * A 3 GiB document made of one 1 MiB block of whitespace from a temporary
+ * file, mapped over and over: it costs neither disk space nor memory, apart
+ * from the few pages written to. (A sparse file would read as NUL bytes,
+ * which end the input.)
+ */
+int test_large_offsets(void) {
+	const size_t block = (size_t)1 << 20, size = (size_t)3 << 30;
+	const size_t key = ((size_t)1 << 31) + 100;
+	char *buf = malloc(block);
+	FILE *f = tmpfile();
+	jsmntok_t tok[4];
+	jsmn_parser p;
+	size_t off;
+	char *js;
+
+	check(buf != NULL && f != NULL);
+	memset(buf, ' ', block);
+	check(fwrite(buf, 1, block, f) == block && fflush(f) == 0);
+	free(buf);
+	js = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	check(js != MAP_FAILED);
+	for (off = 0; off < size; off += block) {
+		check(mmap(js + off, block, PROT_READ | PROT_WRITE,
+					MAP_PRIVATE | MAP_FIXED, fileno(f), 0) == js + off);
+	}
+	fclose(f);
+	js[0] = '{';
+	memcpy(js + key, "\"k\":", 4);
+	memcpy(js + size - 4, "-1 }", 4);
+
+	check(jsmn_validate(js, size) == 3);
+	jsmn_init(&p);
+	check(jsmn_parse(&p, js, size, tok, 4) == 3);
+	check(tok[0].type == JSMN_OBJECT && tok[0].start == 0 &&
+			tok[0].end == (jsmnint_t)size && tok[0].size == 1);
+	check(tok[1].type == JSMN_STRING && tok[1].start == (jsmnint_t)key + 1 &&
+			tok[1].end == (jsmnint_t)key + 2 && tok[1].size == 1);
+	check(tok[2].type == JSMN_PRIMITIVE &&
+			tok[2].start == (jsmnint_t)size - 4 && tok[2].end == (jsmnint_t)size - 2);
+	munmap(js, size);
+	return 0;
+}
+#endif
+
+static const char *events_js;
+
+/* Records events as "<code><depth>:<text> ", stops after a closed array */
+static int record(jsmnevent_t event, jsmnint_t start, jsmnint_t end,
+		jsmnuint_t depth, void *data) {
+	static const char codes[] = " {}[]ksp";
+	char **out = (char **)data;
+
+	*out += sprintf(*out, "%c%u:%.*s ", codes[event], (unsigned)depth,
+			(int)(end - start), events_js + start);
+	return event == JSMN_EVENT_END_ARRAY && depth == 0 ? 42 : 0;
+}
+
+int test_events(void) {
+	char buf[256], *out;
+
+	events_js = "{\"a\": [1, \"b\"], \"c\": {\"d\": null}, \"e\": []}";
+	out = buf;
+	check(jsmn_parse_events(events_js, strlen(events_js), record, &out) == 11);
+	check(strcmp(buf, "{0:{ k1:a [1:[ p2:1 s2:b ]1:] k1:c {1:{ k2:d p2:null "
+				"}1:} k1:e [1:[ ]1:] }0:} ") == 0);
+
+	/* Values before an error are reported, the error is returned */
+	out = buf;
+	events_js = "[\"x\", 2}";
+	check(jsmn_parse_events(events_js, strlen(events_js), record, &out) ==
+			JSMN_ERROR_INVAL);
+	check(strcmp(buf, "[0:[ s1:x p1:2 ") == 0);
+
+	/* A non-zero return stops the parser */
+	out = buf;
+	events_js = "[1, 2] [3]";
+	check(jsmn_parse_events(events_js, strlen(events_js), record, &out) == 42);
+	check(strcmp(buf, "[0:[ p1:1 p1:2 ]0:] ") == 0);
+	return 0;
+}
+
+int test_records(void) {
+	char buf[64];
+	const char *lines = "{\"a\": 1}\n[2, 3]\n\"s\"\n4\n{\"b\": [5]}\n{\"c\"";
+	jsmntok_t tok[16];
+	jsmnrecord_t rec[8];
+	size_t used;
+	jsmnint_t r;
+
+	r = jsmn_parse_records(lines, strlen(lines), tok, 16, rec, 8, &used);
+	check(r == 5);
+	check(rec[0].first == 0 && rec[0].count == 3);
+	check(rec[1].first == 3 && rec[1].count == 3);
+	check(rec[2].first == 6 && rec[2].count == 1);
+	check(rec[3].first == 7 && rec[3].count == 1);
+	check(rec[4].first == 8 && rec[4].count == 4);
+	check(tokeq(lines, tok + rec[4].first, 4,
+				JSMN_OBJECT, 22, 32, 1,
+				JSMN_STRING, "b", 1,
+				JSMN_ARRAY, 28, 31, 1,
+				JSMN_PRIMITIVE, "5"));
+	check(used == 33);
+
+	/* The cut record is carried over to the next buffer */
+	strcpy(buf, lines + used);
+	strcat(buf, ": true}\n7");
+	r = jsmn_parse_records(buf, strlen(buf), tok, 16, rec, 8, &used);
+	check(r == 1 && rec[0].count == 3 && used == strlen(buf) - 1);
+	check(tokeq(buf, tok, 3,
+				JSMN_OBJECT, 0, 11, 1,
+				JSMN_STRING, "c", 1,
+				JSMN_PRIMITIVE, "true"));
+
+	/* Out of room: what fits is returned */
+	r = jsmn_parse_records(lines, strlen(lines), tok, 16, rec, 2, &used);
+	check(r == 2 && used == 16);
+	r = jsmn_parse_records(lines, strlen(lines), tok, 5, rec, 8, &used);
+	check(r == 1 && used == 9);
+	r = jsmn_parse_records(lines, strlen(lines), tok, 2, rec, 8, &used);
+	check(r == JSMN_ERROR_NOMEM && used == 0);
+
+	/* A bad record ends the batch, and is reported on its own */
+	r = jsmn_parse_records("[1]\n[2}\n[3]\n", 12, tok, 16, rec, 8, &used);
+	check(r == 1 && used == 4);
+	r = jsmn_parse_records("[2}\n[3]\n", 8, tok, 16, rec, 8, &used);
+	check(r == JSMN_ERROR_INVAL && used == 0);
+	return 0;
+}
+
+int test_grow(void) {
+	int i, r;
+	char js[8192];
+	jsmn_parser p;
+	jsmntok_t *tok = NULL;
+	jsmnuint_t tokcount = 0;
+	size_t limit = 64 * sizeof(jsmntok_t);
+
+	js[0] = '[';
+	for (i = 0; i < 1000; i++) {
+		memcpy(js + 1 + 6 * i, "[\"a\"],", 6);
+	}
+	js[6000] = ']';
+	js[6001] = '\0';
+
+	/* Starting from nothing, the array doubles until the document fits */
+	jsmn_init(&p);
+	r = jsmn_parse_grow(&p, js, strlen(js), &tok, &tokcount, grow, NULL);
+	check(r == 2001);
+	check(tokcount >= 2001 && tokcount < 4002);
+	check(grow_calls <= 9);
+	check(jsmn_tok_size(&tok[0]) == 1000);
+	check(tokeq(js, tok + 1999, 2,
+				JSMN_ARRAY, 5995, 6000, 1,
+				JSMN_STRING, "a", 0));
+
+	/* A failing allocator leaves the parser ready to carry on */
+	free(tok);
+	tok = NULL;
+	tokcount = 0;
+	jsmn_init(&p);
+	r = jsmn_parse_grow(&p, js, strlen(js), &tok, &tokcount, grow, &limit);
+	check(r == JSMN_ERROR_NOMEM);
+	check(tokcount == 64 && p.toknext == 64);
+	r = jsmn_parse_grow(&p, js, strlen(js), &tok, &tokcount, grow, NULL);
+	check(r == 2001);
+	check(jsmn_tok_type(&tok[2000]) == JSMN_STRING && jsmn_tok_start(&tok[2000]) == 5997);
+	free(tok);
+	return 0;
+}
+
+int test_key_index(void) {
+	const char *js = "{\"a\": {\"a\": 1, \"b\": 2}, \"list\": [{\"c\": 3}], "
+		"\"a\": 4, \"e\\\"\": 5}";
+	char *big = malloc(20000);
+	jsmntok_t t[3000];
+	jsmnslot_t slots[4096];
+	jsmnkeyindex_t index;
+	jsmn_parser p;
+	char key[8];
+	int i, n, r;
+
+	jsmn_init(&p);
+	r = jsmn_parse(&p, js, strlen(js), t, 3000);
+	check(r == 16);
+	index.slots = slots;
+	index.size = jsmn_key_index_size(t, r);
+	check(index.size == 16);
+	check(jsmn_build_key_index(&index, js, t, r) == 7);
+	/* Keys belong to their own object; a repeated key finds the first value */
+	check(jsmn_lookup(&index, js, t, 0, "a") == 2);
+	check(jsmn_lookup(&index, js, t, 2, "a") == 4);
+	check(jsmn_lookup(&index, js, t, 2, "b") == 6);
+	check(jsmn_lookup(&index, js, t, 0, "b") == -1);
+	check(jsmn_lookup(&index, js, t, 0, "list") == 8);
+	check(jsmn_lookup(&index, js, t, 9, "c") == 11);
+	check(jsmn_lookup(&index, js, t, 0, "lis") == -1);
+	/* Escapes are compared as written */
+	check(jsmn_lookup(&index, js, t, 0, "e\\\"") == 15);
+	check(jsmn_lookup(&index, js, t, 0, "e\"") == -1);
+
+	/* Too few slots */
+	index.size = 4;
+	check(jsmn_build_key_index(&index, js, t, r) == JSMN_ERROR_NOMEM);
+
+	/* One object of a thousand keys */
+	n = sprintf(big, "{");
+	for (i = 0; i < 1000; i++) {
+		n += sprintf(big + n, "%s\"k%d\": %d", i ? ", " : "", i, i);
+	}
+	sprintf(big + n, "}");
+	jsmn_init(&p);
+	r = jsmn_parse(&p, big, strlen(big), t, 3000);
+	check(r == 2001);
+	index.size = jsmn_key_index_size(t, r);
+	check(index.size == 2048);
+	check(jsmn_build_key_index(&index, big, t, r) == 1000);
+	for (i = 0; i < 1000; i++) {
+		sprintf(key, "k%d", i);
+		check(jsmn_lookup(&index, big, t, 0, key) == 2 * i + 2);
+	}
+	check(jsmn_lookup(&index, big, t, 0, "k1000") == -1);
+	free(big);
+	return 0;
+}
+
+int test_cursor(void) {
+	const char *js = "{\"a\": [1, [2, 3], {\"b\": 4}], \"c\": {}, \"d\": \"e\"} [5] \"f\"";
+	jsmntok_t t[32];
+	jsmncursor_t c;
+	jsmn_parser p;
+	int r;
+
+	jsmn_init(&p);
+	r = jsmn_parse(&p, js, strlen(js), t, 32);
+	check(r == 17);
+#ifdef JSMN_SPANS
+	check(jsmn_tok_span(&t[0]) == 14 && jsmn_tok_span(&t[2]) == 8);
+	check(jsmn_tok_span(&t[1]) == 1 && jsmn_tok_span(&t[12]) == 1);
+#endif
+	jsmn_cursor_init(&c, t, r);
+	check(jsmn_cursor_parent(&c) == -1);
+	/* Top-level values are siblings */
+	check(jsmn_cursor_next_sibling(&c) == 14);
+	check(jsmn_cursor_next_sibling(&c) == 16);
+	check(jsmn_cursor_next_sibling(&c) == -1 && c.pos == 16);
+	check(jsmn_cursor_first_child(&c) == -1);
+
+	/* Keys, then their values */
+	jsmn_cursor_init(&c, t, r);
+	check(jsmn_cursor_first_child(&c) == 1);
+	check(jsmn_cursor_first_child(&c) == 2);
+	check(jsmn_cursor_next_sibling(&c) == -1);
+	check(jsmn_cursor_first_child(&c) == 3);
+	check(jsmn_cursor_next_sibling(&c) == 4);
+	check(jsmn_cursor_next_sibling(&c) == 7);
+	check(jsmn_cursor_next_sibling(&c) == -1);
+	check(jsmn_cursor_first_child(&c) == 8);
+	check(jsmn_cursor_first_child(&c) == 9);
+	check(jsmn_cursor_parent(&c) == 8);
+	check(jsmn_cursor_parent(&c) == 7);
+	check(jsmn_cursor_parent(&c) == 2);
+	check(jsmn_cursor_parent(&c) == 1);
+	check(jsmn_cursor_next_sibling(&c) == 10);
+	check(jsmn_cursor_first_child(&c) == 11);
+	check(jsmn_cursor_first_child(&c) == -1);
+	check(jsmn_cursor_parent(&c) == 10);
+	check(jsmn_cursor_next_sibling(&c) == 12);
+	check(jsmn_cursor_next_sibling(&c) == -1);
+	check(jsmn_cursor_parent(&c) == 0);
+	check(jsmn_cursor_parent(&c) == -1);
+	return 0;
+}
+
+int test_cursor_deep(void) {
+	char js[512];
+	jsmntok_t t[256];
+	jsmncursor_t c;
+	jsmn_parser p;
+	int i, r;
+
+	/* Deeper than the cursor stack, with a sibling at every level */
+	memset(js, '[', 100);
+	for (i = 0; i < 99; i++) {
+		memcpy(js + 100 + 3 * i, "],1", 3);
+	}
+	strcpy(js + 397, "]");
+	jsmn_init(&p);
+	r = jsmn_parse(&p, js, strlen(js), t, 256);
+	check(r == 199);
+	jsmn_cursor_init(&c, t, r);
+	for (i = 1; i < 100; i++) {
+		check(jsmn_cursor_first_child(&c) == i);
+	}
+	check(jsmn_cursor_first_child(&c) == -1);
+	for (i = 98; i >= 0; i--) {
+		check(jsmn_cursor_next_sibling(&c) == 198 - i);
+		check(jsmn_cursor_next_sibling(&c) == -1);
+		check(jsmn_cursor_parent(&c) == i);
+	}
+	return 0;
+}
+
+/* Reads s, a number on its own, with jsmn_get_double() and tells whether it
+ * gives the very same double as strtod() */
+static int same_double(const char *s) {
+	jsmntok_t t[1];
+	jsmn_parser p;
+	char js[1024];
+	double a, b;
+
+	sprintf(js, "%s ", s);
+	jsmn_init(&p);
+	if (jsmn_parse(&p, js, strlen(js), t, 1) != 1 ||
+			jsmn_get_double(js, &t[0], &a) == JSMN_ERROR_INVAL) {
+		return 0;
+	}
+	b = strtod(s, NULL);
+	return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+int test_numbers(void) {
+	const char *js = "[0, -0, 12345678, 123456789012, -9223372036854775808, "
+		"9223372036854775808, 18446744073709551615, 18446744073709551616, "
+		"1.5, 012, -, 1e5, true, \"1\"]";
+	static const char *doubles[] = {
+		"0", "-0", "1", "-1.5", "0.1", "3.14159", "1e23", "123e-2",
+		"9007199254740993", "9007199254740992.5", "4503599627370497.5",
+		"123456789012345678901234567890", "0.000000000000000000000000000001",
+		"4.9406564584124654e-324", "2.4703282292062327e-324",
+		"2.4703282292062328e-324", "2.2250738585072011e-308",
+		"2.2250738585072012e-308", "1.7976931348623157e308",
+		"1.7976931348623158e308", "1e-400", "7.2057594037927933e16",
+		"1.00000000000000011102230246251565404236316680908203125",
+		"1.00000000000000011102230246251565404236316680908203124",
+		"1.00000000000000011102230246251565404236316680908203126",
+		"9007199254740993.0000000000000000000000000000001"
+	};
+	char s[64];
+	jsmntok_t t[16];
+	jsmn_parser p;
+	int64_t i;
+	uint64_t u;
+	double d;
+	int k, r;
+
+	jsmn_init(&p);
+	r = jsmn_parse(&p, js, strlen(js), t, 16);
+	check(r == 15);
+	check(jsmn_get_int64(js, &t[1], &i) == 0 && i == 0);
+	check(jsmn_get_int64(js, &t[2], &i) == 0 && i == 0);
+	check(jsmn_get_int64(js, &t[3], &i) == 0 && i == 12345678);
+	check(jsmn_get_int64(js, &t[4], &i) == 0 && i == INT64_C(123456789012));
+	check(jsmn_get_int64(js, &t[5], &i) == 0 && i == INT64_MIN);
+	check(jsmn_get_int64(js, &t[6], &i) == JSMN_ERROR_RANGE);
+	check(jsmn_get_uint64(js, &t[6], &u) == 0 && u == UINT64_C(9223372036854775808));
+	check(jsmn_get_uint64(js, &t[7], &u) == 0 && u == UINT64_MAX);
+	check(jsmn_get_uint64(js, &t[8], &u) == JSMN_ERROR_RANGE);
+	check(jsmn_get_uint64(js, &t[5], &u) == JSMN_ERROR_RANGE);
+	check(jsmn_get_int64(js, &t[9], &i) == JSMN_ERROR_INVAL);
+	check(jsmn_get_int64(js, &t[10], &i) == JSMN_ERROR_INVAL);
+	check(jsmn_get_int64(js, &t[12], &i) == JSMN_ERROR_INVAL);
+	check(jsmn_get_int64(js, &t[0], &i) == JSMN_ERROR_INVAL);
+
+	check(jsmn_get_double(js, &t[9], &d) == 0 && d == 1.5);
+	check(jsmn_get_double(js, &t[12], &d) == 0 && d == 1e5);
+	check(jsmn_get_double(js, &t[10], &d) == JSMN_ERROR_INVAL);
+	check(jsmn_get_double(js, &t[11], &d) == JSMN_ERROR_INVAL);
+	check(jsmn_get_double(js, &t[13], &d) == JSMN_ERROR_INVAL);
+	check(jsmn_get_double(js, &t[14], &d) == JSMN_ERROR_INVAL);
+	for (k = 0; k < (int)(sizeof(doubles) / sizeof(doubles[0])); k++) {
+		check(same_double(doubles[k]));
+	}
+	/* Too large */
+	jsmn_init(&p);
+	check(jsmn_parse(&p, "-1e309 ", 7, t, 1) == 1);
+	check(jsmn_get_double("-1e309 ", &t[0], &d) == JSMN_ERROR_RANGE &&
+			d < -1.7976931348623157e308);
+
+	/* Random doubles, printed short and long, and random digits */
+	srand(2);
+	for (k = 0; k < 20000; k++) {
+		uint64_t bits = (uint64_t)rand() << 62 ^ (uint64_t)rand() << 31 ^
+			(uint64_t)rand();
+		memcpy(&d, &bits, sizeof(d));
+		if ((bits >> 52 & 0x7FF) == 0x7FF) {
+			continue;
+		}
+		sprintf(s, k % 2 ? "%.17g" : "%.40e", d);
+		check(same_double(s));
+		sprintf(s, "%d%de%d", rand(), rand(), rand() % 700 - 350);
+		check(same_double(s));
+	}
+	return 0;
+}
+
+/* Index of the only value path selects in js, or -1 if none or several */
+static jsmnint_t path_get(const char *js, const char *expr) {
+	jsmntok_t t[64];
+	jsmnpath_t path;
+	jsmnint_t matches[2];
+	jsmn_parser p;
+	int r;
+
+	jsmn_init(&p);
+	r = jsmn_parse(&p, js, strlen(js), t, 64);
+	if (r < 0 || jsmn_path_compile(&path, expr) < 0) {
+		return -2;
+	}
+	return jsmn_path_eval(&path, js, t, r, matches, 2) == 1 ? matches[0] : -1;
+}
+
+int test_path(void) {
+	/* The examples of RFC 6901 */
+	const char *rfc = "{\"foo\": [\"bar\", \"baz\"], \"\": 0, \"a/b\": 1, "
+		"\"c%d\": 2, \"e^f\": 3, \"g|h\": 4, \"i\\\\j\": 5, \"k\\\"l\": 6, "
+		"\" \": 7, \"m~n\": 8}";
+	const char *js = "{\"items\": [{\"id\": 1, \"tags\": [\"x\"]}, {\"id\": 2}, "
+		"{\"name\": \"y\"}], \"n\": {\"id\": 3}}";
+	const char *esc = "{\"caf\\u00e9\": 1, \"a\\/b\": 2, \"\\ud83d\\ude00\": 3}";
+	char deep[64];
+	jsmntok_t t[64];
+	jsmnpath_t path;
+	jsmnint_t m[8];
+	jsmn_parser p;
+	int r;
+
+	check(path_get(rfc, "") == 0);
+	check(path_get(rfc, "/foo") == 2);
+	check(path_get(rfc, "/foo/0") == 3);
+	check(path_get(rfc, "/foo/1") == 4);
+	check(path_get(rfc, "/") == 6);
+	check(path_get(rfc, "/a~1b") == 8);
+	check(path_get(rfc, "/c%d") == 10);
+	check(path_get(rfc, "/e^f") == 12);
+	check(path_get(rfc, "/g|h") == 14);
+	check(path_get(rfc, "/i\\j") == 16);
+	check(path_get(rfc, "/k\"l") == 18);
+	check(path_get(rfc, "/ ") == 20);
+	check(path_get(rfc, "/m~0n") == 22);
+	check(path_get(rfc, "/foo/2") == -1);
+	check(path_get(rfc, "/foo/-") == -1);
+	check(path_get(rfc, "/foo/01") == -1);
+	check(path_get(rfc, "/foo/0/x") == -1);
+	check(path_get(rfc, "/fo") == -1);
+	check(path_get(esc, "/caf\xc3\xa9") == 2);
+	check(path_get(esc, "/a~1b") == 4);
+	check(path_get(esc, "/\xf0\x9f\x98\x80") == 6);
+
+	check(path_get(js, "$") == 0);
+	check(path_get(js, "$.items[1].id") == 11);
+	check(path_get(js, "$['items'][0].tags[0]") == 8);
+	check(path_get(js, "$.*.id") == 18);
+	check(path_get(js, "$.items.0") == -1);
+	check(path_get(js, "$.items[3]") == -1);
+
+	jsmn_init(&p);
+	r = jsmn_parse(&p, js, strlen(js), t, 64);
+	check(r == 19);
+	check(jsmn_path_compile(&path, "$.items[*].id") == 3);
+	check(jsmn_path_eval(&path, js, t, r, m, 8) == 2);
+	check(m[0] == 5 && m[1] == 11);
+	check(jsmn_path_eval(&path, js, t, r, m, 1) == 1 && m[0] == 5);
+	check(jsmn_path_eval(&path, js, t, r, NULL, 0) == 2);
+	check(jsmn_path_compile(&path, "$.items[*].*") == 3);
+	check(jsmn_path_eval(&path, js, t, r, m, 8) == 4);
+	check(m[0] == 5 && m[1] == 7 && m[2] == 11 && m[3] == 14);
+
+	check(jsmn_path_compile(&path, "a") == JSMN_ERROR_INVAL);
+	check(jsmn_path_compile(&path, "/~2") == JSMN_ERROR_INVAL);
+	check(jsmn_path_compile(&path, "/a~") == JSMN_ERROR_INVAL);
+	check(jsmn_path_compile(&path, "$..a") == JSMN_ERROR_INVAL);
+	check(jsmn_path_compile(&path, "$[x]") == JSMN_ERROR_INVAL);
+	check(jsmn_path_compile(&path, "$.a[") == JSMN_ERROR_INVAL);
+	check(jsmn_path_compile(&path, "$['a'") == JSMN_ERROR_INVAL);
+	memset(deep, 0, sizeof(deep));
+	for (r = 0; r <= JSMN_PATH_STEPS; r++) {
+		strcat(deep, "/a");
+	}
+	check(jsmn_path_compile(&path, deep) == JSMN_ERROR_NOMEM);
+	return 0;
+}
+
+static int same_tokens(const jsmntok_t *a, const jsmntok_t *b, jsmnint_t n) {
+	jsmnint_t i;
+	for (i = 0; i < n; i++) {
+		if (jsmn_tok_type(&a[i]) != jsmn_tok_type(&b[i]) ||
+				jsmn_tok_start(&a[i]) != jsmn_tok_start(&b[i]) ||
+				jsmn_tok_end(&a[i]) != jsmn_tok_end(&b[i]) ||
+				jsmn_tok_size(&a[i]) != jsmn_tok_size(&b[i])) {
+			return 0;
+		}
+#ifdef JSMN_PARENT_LINKS
+		if (a[i].parent != b[i].parent) {
+			return 0;
+		}
+#endif
+#ifdef JSMN_SPANS
+		if (a[i].span != b[i].span) {
+			return 0;
+		}
+#endif
+	}
+	return 1;
+}
+
+int test_select(void) {
+	const char *js = "{\"id\": 7, \"meta\": {\"tags\": [\"a\", \"b\"], \"big\": [1, 2]}, "
+		"\"items\": [{\"id\": 1, \"x\": {\"id\": [1]}}, {\"id\": 2}, 3], "
+		"\"skip\": \"\\\"}]\", \"more\": {\"id\": 4}}";
+	const char *exprs[] = { "/id", "$.items[*].id", "/meta/tags" };
+	char *big = malloc(200000);
+	jsmntok_t t[64], full[64];
+	jsmnpath_t paths[JSMN_SELECT_PATHS + 1];
+	jsmnint_t a[8], b[8];
+	jsmn_parser p;
+	int i, j, n, r;
+
+	for (i = 0; i < 3; i++) {
+		check(jsmn_path_compile(&paths[i], exprs[i]) >= 0);
+	}
+	r = jsmn_parse_select(js, strlen(js), paths, 3, t, 64);
+	check(r == 17);
+	check(tokeq(js, t, 17,
+				JSMN_OBJECT, -1, -1, 3,
+				JSMN_STRING, "id", 1, JSMN_PRIMITIVE, "7",
+				JSMN_STRING, "meta", 1, JSMN_OBJECT, -1, -1, 1,
+				JSMN_STRING, "tags", 1, JSMN_ARRAY, -1, -1, 2,
+				JSMN_STRING, "a", 0, JSMN_STRING, "b", 0,
+				JSMN_STRING, "items", 1, JSMN_ARRAY, -1, -1, 2,
+				JSMN_OBJECT, -1, -1, 1, JSMN_STRING, "id", 1, JSMN_PRIMITIVE, "1",
+				JSMN_OBJECT, -1, -1, 1, JSMN_STRING, "id", 1, JSMN_PRIMITIVE, "2"));
+#ifdef JSMN_PARENT_LINKS
+	check(t[4].parent == 3 && t[6].parent == 5 && t[8].parent == 6 && t[16].parent == 15);
+#endif
+#ifdef JSMN_SPANS
+	check(jsmn_tok_span(&t[0]) == 17 && jsmn_tok_span(&t[10]) == 7);
+#endif
+
+	/* The paths find the same values as on a full parse */
+	jsmn_init(&p);
+	n = jsmn_parse(&p, js, strlen(js), full, 64);
+	check(n > r);
+	for (i = 0; i < 3; i++) {
+		check(jsmn_path_eval(&paths[i], js, t, r, a, 8) ==
+				jsmn_path_eval(&paths[i], js, full, n, b, 8));
+		for (j = 0; j < jsmn_path_eval(&paths[i], js, t, r, a, 8); j++) {
+			check(jsmn_tok_start(&t[a[j]]) == jsmn_tok_start(&full[b[j]]));
+			check(jsmn_tok_size(&t[a[j]]) == jsmn_tok_size(&full[b[j]]));
+		}
+	}
+
+	/* "$" keeps everything */
+	check(jsmn_path_compile(&paths[0], "$") == 0);
+	check(jsmn_parse_select(js, strlen(js), paths, 1, t, 64) == n);
+	check(same_tokens(t, full, n));
+	check(jsmn_parse_select(js, strlen(js), paths, 0, t, 64) == 0);
+
+	check(jsmn_path_compile(&paths[0], "/items") == 1);
+	check(jsmn_parse_select(js, strlen(js), paths, 1, t, 10) == JSMN_ERROR_NOMEM);
+	check(jsmn_parse_select("{\"items\": [1, 2", 15, paths, 1, t, 64) ==
+			JSMN_ERROR_PART);
+	check(jsmn_parse_select("{\"items\" 1}", 11, paths, 1, t, 64) ==
+			JSMN_ERROR_INVAL);
+	check(jsmn_parse_select("{\"x\": [1, {\"y\": 2", 17, paths, 1, t, 64) ==
+			JSMN_ERROR_PART);
+	check(jsmn_parse_select(js, strlen(js), paths, JSMN_SELECT_PATHS + 1,
+				t, 64) == JSMN_ERROR_INVAL);
+
+	/* One field of a thousand records */
+	n = sprintf(big, "{\"items\": [");
+	for (i = 0; i < 1000; i++) {
+		n += sprintf(big + n, "%s{\"id\": %d, \"name\": \"n%d\", \"tags\": "
+				"[1, 2, 3], \"more\": {\"a\": [true, null]}}", i ? ", " : "", i, i);
+	}
+	sprintf(big + n, "]}");
+	check(jsmn_path_compile(&paths[0], "/items/500/name") == 3);
+	check(jsmn_parse_select(big, strlen(big), paths, 1, t, 64) == 6);
+	check(tokeq(big, t + 4, 2, JSMN_STRING, "name", 1, JSMN_STRING, "n500", 0));
+	free(big);
+	return 0;
+}
+
+/* Decodes string token i of js and compares it with the expected bytes */
+static int unescapes_to(const char *js, jsmntok_t *t, int i,
+		const char *want, size_t want_len) {
+	char buf[256];
+	jsmnint_t n = jsmn_unescaped_length(js, &t[i]);
+	return n == (jsmnint_t)want_len &&
+		jsmn_unescape(js, &t[i], buf, sizeof(buf)) == n &&
+		memcmp(buf, want, want_len) == 0;
+}
+
+int test_unescape(void) {
+	const char *js = "[\"plain\", \"a\\\"b\\\\c\\/d\\b\\f\\n\\r\\t\", "
+		"\"\\u0041\\u00e9\\u20ac\\ud83d\\ude00\", \"\\ud800x\\udc00\", \"\", "
+		"\"0123456789abcdef0123456789abcdef0123456789\\n"
+		"0123456789abcdef0123456789abcdef\\u00e9!\", 12]";
+	jsmntok_t t[16];
+	jsmn_parser p;
+	char buf[8];
+	int r;
+
+	jsmn_init(&p);
+	r = jsmn_parse(&p, js, strlen(js), t, 16);
+	check(r == 8);
+	check(unescapes_to(js, t, 1, "plain", 5));
+	check(unescapes_to(js, t, 2, "a\"b\\c/d\b\f\n\r\t", 12));
+	check(unescapes_to(js, t, 3, "A\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80", 10));
+	/* Unpaired surrogates */
+	check(unescapes_to(js, t, 4, "\xef\xbf\xbdx\xef\xbf\xbd", 7));
+	check(unescapes_to(js, t, 5, "", 0));
+	check(unescapes_to(js, t, 6, "0123456789abcdef0123456789abcdef0123456789\n"
+				"0123456789abcdef0123456789abcdef\xc3\xa9!", 78));
+	check(unescapes_to(js, t, 7, "12", 2));
+	check(jsmn_unescaped_length(js, &t[0]) == JSMN_ERROR_INVAL);
+	check(jsmn_unescape(js, &t[0], buf, sizeof(buf)) == JSMN_ERROR_INVAL);
+
+	/* The buffer has to hold it all, however it ends */
+	check(jsmn_unescape(js, &t[1], buf, 5) == 5);
+	check(jsmn_unescape(js, &t[1], buf, 4) == JSMN_ERROR_NOMEM);
+	check(jsmn_unescape(js, &t[3], buf, 5) == JSMN_ERROR_NOMEM);
+	check(jsmn_unescape(js, &t[6], buf, sizeof(buf)) == JSMN_ERROR_NOMEM);
+	return 0;
+}
+
+#ifdef JSMN_UTF8
+/* Reference check: decode loosely, then reject what UTF-8 does not allow */
+static int utf8_ok(const unsigned char *p, size_t n) {
+	size_t i = 0, j, k;
+	unsigned long c;
+
+	while (i < n) {
+		if (p[i] < 0x80) {
+			i++;
+			continue;
+		}
+		k = p[i] >= 0xF0 ? 3 : p[i] >= 0xE0 ? 2 : p[i] >= 0xC0 ? 1 : 0;
+		if (k == 0 || p[i] >= 0xF8 || i + k >= n) {
+			return 0;
+		}
+		c = p[i] & (0x3F >> k);
+		for (j = 1; j <= k; j++) {
+			if ((p[i + j] & 0xC0) != 0x80) {
+				return 0;
+			}
+			c = c << 6 | (p[i + j] & 0x3F);
+		}
+		if (c < (k == 1 ? 0x80 : k == 2 ? 0x800 : 0x10000) || c > 0x10FFFF ||
+				(c >= 0xD800 && c < 0xE000)) {
+			return 0;
+		}
+		i += k + 1;
+	}
+	return 1;
+}
+
+int test_utf8(void) {
+	static const char *pieces[] = { "a", "0123456789abcdef", "\xc3\xa9",
+		"\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xf4\x8f\xbf\xbf", "\xed\x9f\xbf",
+		"\xee\x80\x80", "\x80", "\xbf", "\xc0", "\xc1", "\xc2", "\xdf", "\xe0",
+		"\xed", "\xef", "\xf0", "\xf4", "\xf5", "\xff", "\x8f", "\x90", "\x9f",
+		"\xa0" };
+	char js[256];
+	jsmntok_t t[4];
+	jsmn_parser p;
+	size_t n;
+	int i, r;
+
+	check(parse("[\"caf\xc3\xa9\", \"\xe2\x82\xac\", \"\xf0\x9f\x98\x80\"]", 4, 4,
+				JSMN_ARRAY, 0, 24, 3,
+				JSMN_STRING, "caf\xc3\xa9", 0,
+				JSMN_STRING, "\xe2\x82\xac", 0,
+				JSMN_STRING, "\xf0\x9f\x98\x80", 0));
+	check(parse("[\"\x80\"]", JSMN_ERROR_UTF8, 2));
+	check(parse("[\"\xc0\xaf\"]", JSMN_ERROR_UTF8, 2));
+	check(parse("[\"\xe0\x80\xaf\"]", JSMN_ERROR_UTF8, 2));
+	check(parse("[\"\xed\xa0\x80\"]", JSMN_ERROR_UTF8, 2));
+	check(parse("[\"\xf4\x90\x80\x80\"]", JSMN_ERROR_UTF8, 2));
+	check(parse("[\"\xf5\x80\x80\x80\"]", JSMN_ERROR_UTF8, 2));
+	check(parse("[\"\xe2\x82\"]", JSMN_ERROR_UTF8, 2));
+	check(parse("{\"k\xff\": 1}", JSMN_ERROR_UTF8, 3));
+	check(parse("[\"0123456789abcde\xe2\x82\xac\"]", 2, 2,
+				JSMN_ARRAY, 0, 22, 1,
+				JSMN_STRING, "0123456789abcde\xe2\x82\xac", 0));
+	check(parse("[\"0123456789abcdef0123456789abcd\xe2\x82\"]",
+				JSMN_ERROR_UTF8, 2));
+
+	/* A sequence cut by the end of input is checked once it is complete */
+	strcpy(js, "[\"0123456789abc\xe2\x82\xac\xf0\x9f\x98\x80"
+			"0123456789abcdef\xc3\xa9\"]");
+	for (n = 1; n < strlen(js); n++) {
+		jsmn_init(&p);
+		check(jsmn_parse(&p, js, n, t, 4) == JSMN_ERROR_PART);
+		check(jsmn_parse(&p, js, strlen(js), t, 4) == 2);
+	}
+
+	/* Random strings of valid and invalid pieces, against the reference */
+	srand(22);
+	for (i = 0; i < 20000; i++) {
+		strcpy(js, "[\"");
+		n = 2;
+		while (n < 200 && rand() % 24 != 0) {
+			const char *piece = pieces[rand() % 8 == 0 ?
+				8 + rand() % 17 : rand() % 8];
+			strcpy(js + n, piece);
+			n += strlen(piece);
+		}
+		strcpy(js + n, "\"]");
+		jsmn_init(&p);
+		r = jsmn_parse(&p, js, n + 2, t, 4);
+		check(r == (utf8_ok((const unsigned char *)js + 2, n - 2) ? 2 :
+					JSMN_ERROR_UTF8));
+	}
+	return 0;
+}
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+int test_parse_file(void) {
+	char path[] = "/tmp/jsmn_testXXXXXX";
+	const char *data = "{\"a\": [1, \"bc\"]}";
+	const char *js;
+	size_t len;
+	jsmn_parser p;
+	jsmntok_t *tok = NULL;
+	jsmnuint_t tokcount = 0;
+	int fd = mkstemp(path);
+
+	check(fd >= 0);
+	check(write(fd, data, strlen(data)) == (ssize_t)strlen(data));
+	close(fd);
+
+	/* Tokens point straight into the mapping */
+	jsmn_init(&p);
+	check(jsmn_parse_file(&p, path, &js, &len, &tok, &tokcount,
+				grow, NULL) == 5);
+	check(len == strlen(data) && memcmp(js, data, len) == 0);
+	check(tokeq(js, tok, 5,
+				JSMN_OBJECT, 0, 16, 1,
+				JSMN_STRING, "a", 1,
+				JSMN_ARRAY, 6, 15, 2,
+				JSMN_PRIMITIVE, "1",
+				JSMN_STRING, "bc", 0));
+	jsmn_unmap_file(js, len);
+
+	/* Empty and missing files */
+	fd = open(path, O_WRONLY | O_TRUNC);
+	close(fd);
+	jsmn_init(&p);
+	check(jsmn_parse_file(&p, path, &js, &len, &tok, &tokcount,
+				grow, NULL) == 0);
+	check(len == 0);
+	jsmn_unmap_file(js, len);
+	unlink(path);
+	jsmn_init(&p);
+	check(jsmn_parse_file(&p, path, &js, &len, &tok, &tokcount,
+				grow, NULL) == JSMN_ERROR_FILE);
+	check(js == NULL);
+	free(tok);
+	return 0;
+}
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+/* Appends one random array element: strings with escapes and brackets in
+ * them, numbers, literals and nested objects and arrays */
+static size_t random_value(char *js, size_t n, int depth) {
+	static const char *strings[] = {
+		"\"plain\"", "\"a, b\"", "\"[{\"", "\"\\\"q\\\"\"", "\"\\\\\"",
+		"\"x\\\\\\\"]\"", "\"\\u00e9\"", "\"\""
+	};
+	static const char *primitives[] = { "1", "-2.5e3", "true", "null", "0" };
+	int i, k = rand() % (depth < 4 ? 6 : 4);
+
+	switch (k) {
+		case 0: case 1:
+			return n + sprintf(js + n, "%s", strings[rand() % 8]);
+		case 2: case 3:
+			return n + sprintf(js + n, "%s", primitives[rand() % 5]);
+		case 4:
+			js[n++] = '{';
+			for (i = rand() % 4; i > 0; i--) {
+				n += sprintf(js + n, "%s: ", strings[rand() % 8]);
+				n = random_value(js, n, depth + 1);
+				js[n++] = i > 1 ? ',' : ' ';
+			}
+			js[n++] = '}';
+			return n;
+		default:
+			js[n++] = '[';
+			for (i = rand() % 4; i > 0; i--) {
+				n = random_value(js, n, depth + 1);
+				if (i > 1) {
+					n += sprintf(js + n, ",\n ");
+				}
+			}
+			js[n++] = ']';
+			return n;
+	}
+}
+
+int test_parallel(void) {
+	size_t cap = 1 << 21, n, cut;
+	char *js = malloc(cap);
+	jsmntok_t *ref = malloc(cap * sizeof(jsmntok_t));
+	jsmntok_t *tok = malloc(cap * sizeof(jsmntok_t));
+	jsmn_parser p, q;
+	jsmnint_t r, s;
+	unsigned int threads;
+	int round;
+
+	srand(14);
+	for (round = 0; round < 40; round++) {
+		n = 0;
+		js[n++] = '[';
+		while (n < (size_t)(round + 1) * 500) {
+			n = random_value(js, n, 0);
+			js[n++] = ',';
+			js[n++] = round % 2 ? '\n' : ' ';
+		}
+		n = random_value(js, n, 0);
+		n += sprintf(js + n, "]\n");
+
+		jsmn_init(&p);
+		r = jsmn_parse(&p, js, n, ref, cap);
+		check(r > 0);
+		for (threads = 2; threads <= 9; threads++) {
+			jsmn_init(&q);
+			memset(tok, 0, cap * sizeof(jsmntok_t));
+			s = jsmn_parse_parallel(&q, js, n, tok, cap, threads);
+			check(s == r && q.toknext == p.toknext && q.pos == p.pos);
+			check(same_tokens(ref, tok, r));
+		}
+
+		/* Errors and short token arrays come out as from jsmn_parse() */
+		cut = n / 2 + rand() % (n / 2);
+		jsmn_init(&p);
+		r = jsmn_parse(&p, js, cut, ref, cap);
+		jsmn_init(&q);
+		check(jsmn_parse_parallel(&q, js, cut, tok, cap, 4) == r);
+		js[cut] = '}';
+		jsmn_init(&p);
+		r = jsmn_parse(&p, js, n, ref, cap);
+		jsmn_init(&q);
+		check(jsmn_parse_parallel(&q, js, n, tok, cap, 4) == r);
+		jsmn_init(&q);
+		check(jsmn_parse_parallel(&q, js, n, tok, 10, 4) == JSMN_ERROR_NOMEM ||
+				r == JSMN_ERROR_INVAL);
+	}
+
+	/* A second value after the array: the ranges hold its elements, not
+	 * those of token 0 */
+	n = sprintf(js, "[0] [");
+	for (round = 0; round < 300000; round++) {
+		memcpy(js + n, "\"d\",", 4);
+		n += 4;
+	}
+	n += sprintf(js + n, "1]");
+	jsmn_init(&p);
+	r = jsmn_parse(&p, js, n, ref, cap);
+	jsmn_init(&q);
+	s = jsmn_parse_parallel(&q, js, n, tok, cap, 4);
+	check(s == r);
+	check(r < 0 || same_tokens(ref, tok, r));
+#ifndef JSMN_PACKED
+	check(r < 0 || (tok[0].end == 3 && tok[0].size == 1));
+#endif
+
+	/* Malformed input comes out as from jsmn_parse() too */
+	for (round = 0; round < 200; round++) {
+		int k;
+		n = 0;
+		js[n++] = '[';
+		while (n < 4000) {
+			n = random_value(js, n, 0);
+			js[n++] = ',';
+		}
+		n = random_value(js, n, 0);
+		js[n++] = ']';
+		for (k = rand() % 3; k >= 0; k--) {
+			js[1 + rand() % (n - 2)] = "[]{}\",: "[rand() % 8];
+		}
+		jsmn_init(&p);
+		r = jsmn_parse(&p, js, n, ref, cap);
+		jsmn_init(&q);
+		s = jsmn_parse_parallel(&q, js, n, tok, cap, 2 + round % 7);
+		check(s == r);
+		check(r < 0 || same_tokens(ref, tok, r));
+	}
+
+	/* Quotes, brackets and backslashes in primitives, which jsmn_parse()
+	 * keeps in the primitive */
+	n = sprintf(js, "[");
+	for (round = 0; round < 2; round++) {
+		n += sprintf(js + n, "7,{\"k\": \"v, w\"},2\\\"d,[1, \"x\"],[1, \"x\"],"
+				"\"\\\\\",[1, \"x\"],1\"z,{\"k\": \"v, w\"},1\"z,"
+				"{\"k\": \"v, w\"},7,{\"k\": \"v, w\"},");
+	}
+	n += sprintf(js + n, "7]");
+	jsmn_init(&p);
+	r = jsmn_parse(&p, js, n, ref, cap);
+	for (threads = 2; threads <= 9; threads++) {
+		jsmn_init(&q);
+		check(jsmn_parse_parallel(&q, js, n, tok, cap, threads) == r);
+		check(r < 0 || same_tokens(ref, tok, r));
+	}
+	for (round = 0; round < 2000; round++) {
+		static const char *values[] = {
+			"1\"z", "2\\\"d", "{\"k\": \"v, w\"}", "\"\\\\\"", "[1, \"x\"]", "7"
+		};
+		n = 0;
+		js[n++] = '[';
+		while (n < 60) {
+			n += sprintf(js + n, "%s,", values[rand() % 6]);
+		}
+		n += sprintf(js + n, "%s]", values[rand() % 6]);
+		jsmn_init(&p);
+		r = jsmn_parse(&p, js, n, ref, cap);
+		jsmn_init(&q);
+		s = jsmn_parse_parallel(&q, js, n, tok, cap, 4 + round % 3);
+		check(s == r);
+		check(r < 0 || same_tokens(ref, tok, r));
+	}
+
+	/* Anything but an array is parsed on one thread */
+	jsmn_init(&q);
+	check(jsmn_parse_parallel(&q, "{\"a\": [1, 2]}", 14, tok, 8, 4) == 5);
+	free(js);
+	free(ref);
+	free(tok);
+	return 0;
+}
+
+int test_batch(void) {
+	static const char *bodies[] = {
+		"{\"a\": [1, \"bc\"]}", "[]", "\"s\"", "{\"a\": 1]", "[1, 2", "",
+		"{\"id\": 7, \"tags\": [\"x\", \"y\", {\"z\": null}]}"
+	};
+	size_t i, n = 5000, parsed, expect;
+	jsmndoc_t *docs = malloc(n * sizeof(jsmndoc_t));
+	char *big = malloc(100000);
+	jsmntok_t ref[16];
+	jsmn_parser p;
+	jsmn_pool *pool;
+	unsigned int threads;
+	int round;
+
+	/* One document larger than an arena block */
+	big[0] = '[';
+	for (i = 0; i < 20000; i++) {
+		memcpy(big + 1 + 2 * i, "1,", 2);
+	}
+	big[40000] = ']';
+
+	for (threads = 1; threads <= 8; threads *= 2) {
+		pool = jsmn_pool_new(threads);
+		check(pool != NULL);
+		/* The arenas are reused by the second batch */
+		for (round = 0; round < 2; round++) {
+			expect = 0;
+			for (i = 0; i < n; i++) {
+				docs[i].js = bodies[(i + round) % 7];
+				docs[i].len = strlen(docs[i].js);
+				if (i == 1234) {
+					docs[i].js = big;
+					docs[i].len = 40001;
+				}
+			}
+			parsed = jsmn_parse_batch(pool, docs, n);
+			for (i = 0; i < n; i++) {
+				jsmn_init(&p);
+				if (i == 1234) {
+					check(docs[i].r == 20001);
+					check(jsmn_tok_size(&docs[i].tokens[0]) == 20000);
+					check(jsmn_tok_start(&docs[i].tokens[20000]) == 39999);
+					expect++;
+					continue;
+				}
+				check(docs[i].r == jsmn_parse(&p, docs[i].js, docs[i].len, ref, 16));
+				if (docs[i].r >= 0) {
+					check(same_tokens(ref, docs[i].tokens, docs[i].r));
+					expect++;
+				} else {
+					check(docs[i].tokens == NULL);
+				}
+			}
+			check(parsed == expect);
+		}
+		jsmn_pool_free(pool);
+	}
+	free(big);
+	free(docs);
+	return 0;
+}
+#endif
+
 int main(void) {
 	test(test_empty, "test for a empty JSON objects/arrays");
 	test(test_object, "test for a JSON objects");
@@ -401,7 +1846,39 @@ int main(void) {
 	test(test_issue_27, "test issue #27");
 	test(test_count, "test tokens count estimation");
 	test(test_nonstrict, "test for non-strict mode");
+	test(test_variants, "test strict and lenient parsers side by side");
 	test(test_unmatched_brackets, "test for unmatched brackets");
+	test(test_whitespace_runs, "test long whitespace runs");
+	test(test_long_strings, "test long string bodies");
+	test(test_deep_nesting, "test nesting deeper than the parser stack");
+	test(test_wide_array, "test wide arrays");
+	test(test_stream_chunks, "test input streamed in chunks");
+	test(test_partial_resume, "test resuming cut strings and primitives");
+	test(test_validate, "test validating without tokens");
+#ifdef JSMN_PACKED
+	test(test_packed, "test packed tokens");
+#endif
+#if defined(JSMN_LARGE) && defined(__unix__)
+	test(test_large_offsets, "test offsets past 2 GiB");
+#endif
+	test(test_events, "test event callbacks");
+	test(test_records, "test batches of records");
+	test(test_grow, "test growing the token array");
+	test(test_key_index, "test key index lookups");
+	test(test_cursor, "test cursor navigation");
+	test(test_cursor_deep, "test cursor below the stack depth");
+	test(test_numbers, "test reading numbers");
+	test(test_path, "test JSON Pointer and path queries");
+	test(test_select, "test parsing only selected values");
+	test(test_unescape, "test decoding string escapes");
+#ifdef JSMN_UTF8
+	test(test_utf8, "test UTF-8 validation of strings");
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+	test(test_parse_file, "test parsing a mapped file");
+	test(test_parallel, "test parsing an array on several threads");
+	test(test_batch, "test parsing batches of documents");
+#endif
 	printf("\nPASSED: %d\nFAILED: %d\n", test_passed, test_failed);
 	return (test_failed > 0);
 }
@@ -0,0 +1,469 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "../Library/JsmnUefiLib/JsmnUefiLib.c"
+
+/*
+ * Host-side tests for JsmnUefiLib. Besides the checks below, every build
+ * prints a digest of the tokens produced for a set of generated documents,
+ * so that the output of the scalar and JSMN_SIMD builds can be compared
+ * byte by byte.
+ */
+
+static CHAR16 *widen(const char *s, UINTN len) {
+	UINTN i;
+	CHAR16 *w = malloc((len + 1) * sizeof(CHAR16));
+	for (i = 0; i < len; i++) {
+		w[i] = (unsigned char)s[i];
+	}
+	w[len] = 0;
+	return w;
+}
+
+static int uparse(const char *s, INT32 status, JSMNTOK_T *t, UINT32 numtok) {
+	JSMN_PARSER p;
+	CHAR16 *w = widen(s, strlen(s));
+	INT32 r;
+
+	JsmnInit(&p);
+	r = (INT32)JsmnParser(&p, w, strlen(s), t, numtok);
+	free(w);
+	return r == status;
+}
+
+#define tokeq(t, type_, start_, end_, size_) \
+	((t).Type == (type_) && (t).Start == (start_) && (t).End == (end_) && \
+	 (t).Size == (size_))
+
+int test_uefi_basic(void) {
+	JSMNTOK_T t[8];
+
+	check(uparse("{\"a\": [1, \"b\"]}", 5, t, 8));
+	check(tokeq(t[0], JSMN_OBJECT, 0, 15, 1));
+	check(tokeq(t[1], JSMN_STRING, 2, 3, 1));
+	check(tokeq(t[2], JSMN_ARRAY, 6, 14, 2));
+	check(tokeq(t[3], JSMN_PRIMITIVE, 7, 8, 0));
+	check(tokeq(t[4], JSMN_STRING, 11, 12, 0));
+	check(uparse("{\"a\": 1]", JSMN_ERROR_INVAL, t, 8));
+	check(uparse("{\"a\": \"\\q\"}", JSMN_ERROR_INVAL, t, 8));
+	check(uparse("{\"a\": \"b", JSMN_ERROR_PART, t, 8));
+	return 0;
+}
+
+int test_uefi_wide_chars(void) {
+	CHAR16 w[80];
+	JSMNTOK_T t[4];
+	JSMN_PARSER p;
+	UINTN i;
+
+	/* Code units above 0xFF must never be taken for ASCII delimiters */
+	w[0] = '[';
+	w[1] = '"';
+	for (i = 2; i < 70; i++) {
+		w[i] = (CHAR16)(0x2200 + i);  /* 0x2222, 0x225C: '"' and '\\' in the low byte */
+	}
+	w[70] = '"';
+	w[71] = ',';
+	for (i = 72; i < 78; i++) {
+		w[i] = 0x0a20;
+	}
+	w[78] = ']';
+	w[79] = 0;
+	JsmnInit(&p);
+	check((INT32)JsmnParser(&p, w, 79, t, 4) == JSMN_ERROR_INVAL);
+	JsmnInit(&p);
+	check((INT32)JsmnParser(&p, w, 71, t, 4) == JSMN_ERROR_PART);
+	w[71] = ']';
+	JsmnInit(&p);
+	check((INT32)JsmnParser(&p, w, 72, t, 4) == 2);
+	check(tokeq(t[0], JSMN_ARRAY, 0, 72, 1));
+	check(tokeq(t[1], JSMN_STRING, 2, 70, 0));
+	return 0;
+}
+
+int test_uefi_grow(void) {
+	const char *s = "{\"a\": [1, 2, 3, 4, 5, 6, 7, 8, 9], \"b\": {\"c\": [[], [[]]]}}";
+	CHAR16 *w = widen(s, strlen(s));
+	JSMNTOK_T *t = NULL;
+	UINT32 n = 0;
+	JSMN_PARSER p;
+
+	JsmnInit(&p);
+	check(JsmnParserGrow(&p, w, strlen(s), &t, &n) == 19);
+	check(n == 32);
+	check(tokeq(t[0], JSMN_OBJECT, 0, (INT32)strlen(s), 2));
+	check(tokeq(t[15], JSMN_ARRAY, 46, 56, 2));
+	FreePool(t);
+	free(w);
+	return 0;
+}
+
+int test_uefi_key_index(void) {
+	const char *s = "{\"a\": {\"a\": 1, \"#\": 2}, \"b\": [{\"c\": 3}], \"#\": 4}";
+	CHAR16 *w = widen(s, strlen(s));
+	CHAR16 Key[2] = { 0, 0 };
+	JSMNTOK_T t[16];
+	JSMN_SLOT Slots[16];
+	JSMN_KEY_INDEX Index;
+	JSMN_PARSER p;
+	UINTN i;
+	INT32 r;
+
+	/* Keys are compared code unit by code unit, not just their low bytes */
+	for (i = 0; i < strlen(s); i++) {
+		if (w[i] == '#') {
+			w[i] = 0x20AC;
+		}
+	}
+	JsmnInit(&p);
+	r = (INT32)JsmnParser(&p, w, strlen(s), t, 16);
+	check(r == 14);
+	Index.Slots = Slots;
+	Index.Size = JsmnKeyIndexSize(t, r);
+	check(Index.Size == 16);
+	check(JsmnBuildKeyIndex(&Index, w, t, r) == 6);
+	Key[0] = 'a';
+	check(JsmnLookup(&Index, w, t, 0, Key) == 2);
+	check(JsmnLookup(&Index, w, t, 2, Key) == 4);
+	Key[0] = 'b';
+	check(JsmnLookup(&Index, w, t, 0, Key) == 8);
+	check(JsmnLookup(&Index, w, t, 2, Key) == -1);
+	Key[0] = 'c';
+	check(JsmnLookup(&Index, w, t, 9, Key) == 11);
+	Key[0] = 0x20AC;
+	check(JsmnLookup(&Index, w, t, 0, Key) == 13);
+	check(JsmnLookup(&Index, w, t, 2, Key) == 6);
+	Key[0] = 0xAC;
+	check(JsmnLookup(&Index, w, t, 0, Key) == -1);
+	free(w);
+	return 0;
+}
+
+int test_uefi_numbers(void) {
+	const char *s = "[0, -0, 12345678, 123456789012, -9223372036854775808, "
+		"9223372036854775808, 18446744073709551615, 18446744073709551616, "
+		"1.5, 012]";
+	CHAR16 *w = widen(s, strlen(s));
+	JSMNTOK_T t[16];
+	JSMN_PARSER p;
+	INT64 i;
+	UINT64 u;
+	INT32 r;
+
+	JsmnInit(&p);
+	r = (INT32)JsmnParser(&p, w, strlen(s), t, 16);
+	check(r == 11);
+	check(JsmnGetInt64(w, &t[1], &i) == 0 && i == 0);
+	check(JsmnGetInt64(w, &t[2], &i) == 0 && i == 0);
+	check(JsmnGetInt64(w, &t[3], &i) == 0 && i == 12345678);
+	check(JsmnGetInt64(w, &t[4], &i) == 0 && i == 123456789012LL);
+	check(JsmnGetInt64(w, &t[5], &i) == 0 && i == -9223372036854775807LL - 1);
+	check(JSMN_ERROR_RANGE == -5);
+	check(JsmnGetInt64(w, &t[6], &i) == JSMN_ERROR_RANGE);
+	check(JsmnGetUint64(w, &t[6], &u) == 0 && u == 9223372036854775808ULL);
+	check(JsmnGetUint64(w, &t[7], &u) == 0 && u == 18446744073709551615ULL);
+	check(JsmnGetUint64(w, &t[8], &u) == JSMN_ERROR_RANGE);
+	check(JsmnGetUint64(w, &t[5], &u) == JSMN_ERROR_RANGE);
+	check(JsmnGetInt64(w, &t[9], &i) == JSMN_ERROR_INVAL);
+	check(JsmnGetInt64(w, &t[10], &i) == JSMN_ERROR_INVAL);
+	check(JsmnGetInt64(w, &t[0], &i) == JSMN_ERROR_INVAL);
+	/* A code unit whose low byte is a digit is not one */
+	w[t[3].Start + 2] = 0x0133;
+	check(JsmnGetInt64(w, &t[3], &i) == JSMN_ERROR_INVAL);
+	free(w);
+	return 0;
+}
+
+/* Decodes string token i of w and compares it with the expected units */
+static int unescapes_to(const CHAR16 *w, JSMNTOK_T *t, int i,
+		const CHAR16 *want, INT32 want_len) {
+	CHAR16 Buffer[64];
+	INT32 n = JsmnUnescapedLength(w, &t[i]);
+	return n == want_len && JsmnUnescape(w, &t[i], Buffer, 64) == n &&
+		memcmp(Buffer, want, want_len * sizeof(CHAR16)) == 0;
+}
+
+int test_uefi_unescape(void) {
+	const char *s = "[\"a\\\"b\\\\c\\/d\\b\\f\\n\\r\\t\", "
+		"\"\\u0041\\u20ac\\ud83d\\ude00\", "
+		"\"0123456789abcdef\\n0123456789#\"]";
+	static const CHAR16 Escapes[] = { 'a', '"', 'b', '\\', 'c', '/', 'd',
+		'\b', '\f', '\n', '\r', '\t' };
+	static const CHAR16 Units[] = { 'A', 0x20AC, 0xD83D, 0xDE00 };
+	static const CHAR16 Long[] = { '0', '1', '2', '3', '4', '5', '6', '7',
+		'8', '9', 'a', 'b', 'c', 'd', 'e', 'f', '\n', '0', '1', '2', '3', '4',
+		'5', '6', '7', '8', '9', 0x4E2D };
+	CHAR16 *w = widen(s, strlen(s));
+	CHAR16 Buffer[4];
+	JSMNTOK_T t[8];
+	JSMN_PARSER p;
+	UINTN i;
+	INT32 r;
+
+	/* Code units above 0xFF are copied whole */
+	for (i = 0; i < strlen(s); i++) {
+		if (w[i] == '#') {
+			w[i] = 0x4E2D;
+		}
+	}
+	JsmnInit(&p);
+	r = (INT32)JsmnParser(&p, w, strlen(s), t, 8);
+	check(r == 4);
+	check(unescapes_to(w, t, 1, Escapes, 12));
+	check(unescapes_to(w, t, 2, Units, 4));
+	check(unescapes_to(w, t, 3, Long, 28));
+	check(JsmnUnescapedLength(w, &t[0]) == JSMN_ERROR_INVAL);
+	check(JsmnUnescape(w, &t[1], Buffer, 4) == JSMN_ERROR_NOMEM);
+	check(JsmnUnescape(w, &t[2], Buffer, 4) == 4);
+	check(JsmnUnescape(w, &t[2], Buffer, 3) == JSMN_ERROR_NOMEM);
+	free(w);
+	return 0;
+}
+
+#ifdef JSMN_PACKED
+int test_uefi_packed(void) {
+	const char *s = "{\"a\": [1, \"bc\"]}";
+	CHAR16 *w = malloc(0x10000 * sizeof(CHAR16));
+	JSMNTOK_T t[8];
+	JSMN_PARSER p;
+	UINTN i;
+
+	check(sizeof(JSMNTOK_T) == 8);
+	check(uparse(s, 5, t, 8));
+	check(tokeq(t[0], JSMN_OBJECT, 0, 16, 1));
+	check(tokeq(t[4], JSMN_STRING, 11, 13, 0));
+
+	/* Offsets have to fit in 16 bits */
+	for (i = 0; i < 0x10000; i++) {
+		w[i] = ' ';
+	}
+	w[0] = '[';
+	w[0xFFFD] = ']';
+	JsmnInit(&p);
+	check((INT32)JsmnParser(&p, w, 0xFFFE, t, 8) == 1);
+	check(tokeq(t[0], JSMN_ARRAY, 0, 0xFFFE, 0));
+	JsmnInit(&p);
+	check((INT32)JsmnParser(&p, w, 0xFFFF, t, 8) == JSMN_ERROR_INVAL);
+	free(w);
+	return 0;
+}
+#endif
+
+/*
+ * Generated documents: pretty-printed records, long strings with escapes
+ * and non-ASCII text, and a minified array of numbers.
+ */
+static CHAR16 *gen_doc(int kind, UINTN *len) {
+#ifdef JSMN_PACKED
+	UINTN cap = 0xF000, n = 0;
+#else
+	UINTN cap = 1 << 22, n = 0;
+#endif
+	CHAR16 *w = malloc(cap * sizeof(CHAR16));
+	char buf[256];
+	int i, j;
+
+#define PUT(s) do { const char *q_ = (s); while (*q_) w[n++] = (unsigned char)*q_++; } while (0)
+	PUT("[");
+	for (i = 0; n < cap - 4096; i++) {
+		if (i > 0) {
+			PUT(kind == 2 ? "," : ",\n");
+		}
+		switch (kind) {
+		case 0:
+			sprintf(buf, "    {\n        \"id\": %d,\n        \"name\": \"user%d\",\n"
+					"        \"tags\": [ \"a\", \"b\" ],\n        \"ok\": true\n    }", i, i);
+			PUT(buf);
+			break;
+		case 1:
+			PUT("  \"");
+			for (j = 0; j < 500 + i % 300; j++) {
+				if (j % 97 == 96) {
+					PUT("\\u00e9\\n");
+				} else {
+					w[n++] = (CHAR16)(j % 5 == 0 ? 0x4e2d + j % 7 : 'a' + j % 26);
+				}
+			}
+			PUT("\"");
+			break;
+		default:
+			sprintf(buf, "%d", i * 7919 % 100003);
+			PUT(buf);
+			break;
+		}
+	}
+	PUT("]");
+#undef PUT
+	w[n] = 0;
+	*len = n;
+	return w;
+}
+
+int test_uefi_corpus(void) {
+	static const char *names[] = { "pretty", "strings", "numbers" };
+	UINT32 numtok = 1 << 22;
+	JSMNTOK_T *t = malloc(numtok * sizeof(JSMNTOK_T));
+	int kind;
+
+	for (kind = 0; kind < 3; kind++) {
+		UINTN len, i;
+		CHAR16 *w = gen_doc(kind, &len);
+		JSMN_PARSER p;
+		INT32 r;
+		UINT32 digest = 2166136261u;
+
+		JsmnInit(&p);
+		r = (INT32)JsmnParser(&p, w, len, t, numtok);
+		check(r > 0);
+		for (i = 0; i < (UINTN)r; i++) {
+			digest = (digest ^ (UINT32)t[i].Type) * 16777619u;
+			digest = (digest ^ (UINT32)t[i].Start) * 16777619u;
+			digest = (digest ^ (UINT32)t[i].End) * 16777619u;
+			digest = (digest ^ (UINT32)t[i].Size) * 16777619u;
+		}
+		printf("%s: %d tokens, digest %08x\n", names[kind], (int)r, (unsigned)digest);
+		free(w);
+	}
+	free(t);
+	return 0;
+}
+
+/*
+ * JsmnParserAscii() must produce the same tokens as JsmnParser() does for
+ * the same text widened to CHAR16.
+ */
+int test_uefi_ascii(void) {
+	const char *utf8 = "{\"name\": \"caf\xc3\xa9 \xe4\xb8\xad\", \"n\": 1}";
+	UINT32 numtok = 1 << 22;
+	JSMNTOK_T *t = malloc(numtok * sizeof(JSMNTOK_T));
+	JSMNTOK_T *u = malloc(numtok * sizeof(JSMNTOK_T));
+	JSMN_PARSER p;
+	int kind;
+
+	for (kind = 0; kind < 3; kind++) {
+		UINTN len, i;
+		CHAR16 *w = gen_doc(kind, &len);
+		CHAR8 *a = malloc(len + 1);
+		INT32 r, q;
+
+		for (i = 0; i < len; i++) {
+			if (w[i] >= 0x80) {
+				w[i] = 'z';
+			}
+			a[i] = (CHAR8)w[i];
+		}
+		JsmnInit(&p);
+		r = (INT32)JsmnParser(&p, w, len, t, numtok);
+		JsmnInit(&p);
+		q = (INT32)JsmnParserAscii(&p, a, len, u, numtok);
+		check(r > 0 && r == q);
+		for (i = 0; i < (UINTN)r; i++) {
+			check(tokeq(u[i], t[i].Type, t[i].Start, t[i].End, t[i].Size));
+		}
+		/* Cut short, both report a partial document */
+		JsmnInit(&p);
+		check((INT32)JsmnParserAscii(&p, a, len / 2, u, numtok) == JSMN_ERROR_PART);
+		free(a);
+		free(w);
+	}
+
+	/* UTF-8 in strings passes through, offsets are in bytes */
+	JsmnInit(&p);
+	check((INT32)JsmnParserAscii(&p, utf8, strlen(utf8), t, 8) == 5);
+	check(tokeq(t[2], JSMN_STRING, 10, 19, 0));
+	check(tokeq(t[4], JSMN_PRIMITIVE, 27, 28, 0));
+
+	/* ...but not in primitives */
+	JsmnInit(&p);
+	check((INT32)JsmnParserAscii(&p, "[1\xc3\xa9]", 6, t, 8) == JSMN_ERROR_INVAL);
+	JsmnInit(&p);
+	check((INT32)JsmnParserAscii(&p, "{\"a\": [1, \"b\"]}", 15, t, 3) == JSMN_ERROR_NOMEM);
+	free(u);
+	free(t);
+	return 0;
+}
+
+/*
+ * The named variants are built whatever JSMN_STRICT and JSMN_PARENT_LINKS
+ * say, for CHAR16 and CHAR8 input alike.
+ */
+int test_uefi_variants(void) {
+	const char *s = "{a: [1, \"b\"]}";
+	const char *j = "{\"a\": [1, \"b\"]}";
+	CHAR16 *w = widen(s, strlen(s));
+	CHAR16 *x = widen(j, strlen(j));
+	JSMNPLAINTOK_T t[8];
+	JSMNLINKTOK_T u[8];
+	JSMN_PARSER p;
+
+	JsmnInit(&p);
+	check((INT32)JsmnParserStrict(&p, w, strlen(s), t, 8) == JSMN_ERROR_INVAL);
+	JsmnInit(&p);
+	check((INT32)JsmnParserLenient(&p, w, strlen(s), t, 8) == 5);
+	check(tokeq(t[1], JSMN_PRIMITIVE, 1, 2, 1));
+	JsmnInit(&p);
+	check((INT32)JsmnParserAsciiStrictLinks(&p, s, strlen(s), u, 8) == JSMN_ERROR_INVAL);
+	JsmnInit(&p);
+	check((INT32)JsmnParserAsciiLenientLinks(&p, s, strlen(s), u, 8) == 5);
+	check(tokeq(u[2], JSMN_ARRAY, 4, 12, 2));
+	check(u[0].Parent == -1 && u[2].Parent == 1 && u[4].Parent == 2);
+
+	JsmnInit(&p);
+	check((INT32)JsmnParserStrictLinks(&p, x, strlen(j), u, 8) == 5);
+	check(tokeq(u[4], JSMN_STRING, 11, 12, 0) && u[4].Parent == 2);
+	JsmnInit(&p);
+	check((INT32)JsmnParserAsciiStrict(&p, j, strlen(j), t, 8) == 5);
+	check(tokeq(t[4], JSMN_STRING, 11, 12, 0));
+	free(x);
+	free(w);
+	return 0;
+}
+
+/*
+ * Input fed a few characters at a time, cut inside strings, escapes and
+ * primitives, gives the tokens of a single call.
+ */
+int test_uefi_resume(void) {
+	const char *s = "{\"key\": \"a\\u00e9b\\n\", \"n\": [12345, true]}";
+	UINTN len = strlen(s), step, end, i;
+	CHAR16 *w = widen(s, len);
+	JSMNPLAINTOK_T t[8], u[8];
+	JSMN_PARSER p;
+	INT32 r;
+
+	JsmnInit(&p);
+	r = (INT32)JsmnParserStrict(&p, w, len, t, 8);
+	check(r == 7);
+	for (step = 1; step <= 5; step++) {
+		JsmnInit(&p);
+		for (end = step; end < len; end += step) {
+			check((INT32)JsmnParserStrict(&p, w, end, u, 8) == JSMN_ERROR_PART);
+		}
+		check((INT32)JsmnParserStrict(&p, w, len, u, 8) == r);
+		for (i = 0; i < (UINTN)r; i++) {
+			check(tokeq(u[i], t[i].Type, t[i].Start, t[i].End, t[i].Size));
+		}
+	}
+	free(w);
+	return 0;
+}
+
+int main(void) {
+	test(test_uefi_basic, "test JsmnParser on CHAR16 input");
+	test(test_uefi_wide_chars, "test code units above 0xFF");
+	test(test_uefi_grow, "test JsmnParserGrow");
+	test(test_uefi_key_index, "test key index lookups");
+	test(test_uefi_numbers, "test reading integers");
+	test(test_uefi_unescape, "test decoding string escapes");
+#ifdef JSMN_PACKED
+	test(test_uefi_packed, "test packed tokens");
+#endif
+	test(test_uefi_corpus, "test generated documents");
+	test(test_uefi_ascii, "test JsmnParserAscii on CHAR8 input");
+	test(test_uefi_variants, "test strict, lenient and linked parsers side by side");
+	test(test_uefi_resume, "test resuming input cut anywhere");
+	printf("\nPASSED: %d\nFAILED: %d\n", test_passed, test_failed);
+	return (test_failed > 0);
+}
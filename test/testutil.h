@@ -26,31 +26,36 @@ static int vtokeq(const char *s, jsmntok_t *t, int numtok, va_list ap) {
 				size = va_arg(ap, int);
 				value = NULL;
 			}
-			if (t[i].type != type) {
-				printf("token %d type is %d, not %d\n", i, t[i].type, type);
+			if (jsmn_tok_type(&t[i]) != type) {
+				printf("token %d type is %d, not %d\n", i, jsmn_tok_type(&t[i]), type);
 				return 0;
 			}
 			if (start != -1 && end != -1) {
-				if (t[i].start != start) {
-					printf("token %d start is %d, not %d\n", i, t[i].start, start);
+				if (jsmn_tok_start(&t[i]) != start) {
+					printf("token %d start is %d, not %d\n", i, (int)jsmn_tok_start(&t[i]), start);
 					return 0;
 				}
-				if (t[i].end != end ) {
-					printf("token %d end is %d, not %d\n", i, t[i].end, end);
+#ifdef JSMN_PACKED
+				/* Packed tokens do not keep the end of objects and arrays */
+				if (type != JSMN_OBJECT && type != JSMN_ARRAY &&
+						jsmn_tok_end(&t[i]) != end) {
+#else
+				if (jsmn_tok_end(&t[i]) != end) {
+#endif
+					printf("token %d end is %d, not %d\n", i, (int)jsmn_tok_end(&t[i]), end);
 					return 0;
 				}
 			}
-			if (size != -1 && t[i].size != size) {
-				printf("token %d size is %d, not %d\n", i, t[i].size, size);
+			if (size != -1 && jsmn_tok_size(&t[i]) != size) {
+				printf("token %d size is %d, not %d\n", i, (int)jsmn_tok_size(&t[i]), size);
 				return 0;
 			}
 
 			if (s != NULL && value != NULL) {
-				const char *p = s + t[i].start;
-				if (strlen(value) != t[i].end - t[i].start ||
-						strncmp(p, value, t[i].end - t[i].start) != 0) {
-					printf("token %d value is %.*s, not %s\n", i, t[i].end-t[i].start,
-							s+t[i].start, value);
+				int tlen = jsmn_tok_end(&t[i]) - jsmn_tok_start(&t[i]);
+				const char *p = s + jsmn_tok_start(&t[i]);
+				if (strlen(value) != tlen || strncmp(p, value, tlen) != 0) {
+					printf("token %d value is %.*s, not %s\n", i, tlen, p, value);
 					return 0;
 				}
 			}
@@ -0,0 +1,24 @@
+#ifndef __HOST_BASE_LIB_H__
+#define __HOST_BASE_LIB_H__
+
+/*
+ * Host versions of the EDK2 BaseLib routines used by JsmnUefiLib.
+ */
+
+static inline INTN LowBitSet32(UINT32 Operand) {
+	return Operand == 0 ? -1 : __builtin_ctz(Operand);
+}
+
+static inline INTN LowBitSet64(UINT64 Operand) {
+	return Operand == 0 ? -1 : __builtin_ctzll(Operand);
+}
+
+static inline UINT64 LShiftU64(UINT64 Operand, UINTN Count) {
+	return Operand << Count;
+}
+
+static inline UINT64 RShiftU64(UINT64 Operand, UINTN Count) {
+	return Operand >> Count;
+}
+
+#endif /* __HOST_BASE_LIB_H__ */
@@ -0,0 +1,24 @@
+#ifndef __HOST_MEMORY_ALLOCATION_LIB_H__
+#define __HOST_MEMORY_ALLOCATION_LIB_H__
+
+/*
+ * Host versions of the EDK2 MemoryAllocationLib routines used by
+ * JsmnUefiLib, on top of the C library allocator.
+ */
+
+#include <stdlib.h>
+
+static inline VOID *AllocatePool(UINTN AllocationSize) {
+	return malloc(AllocationSize);
+}
+
+static inline VOID *ReallocatePool(UINTN OldSize, UINTN NewSize, VOID *OldBuffer) {
+	(void)OldSize;
+	return realloc(OldBuffer, NewSize);
+}
+
+static inline VOID FreePool(VOID *Buffer) {
+	free(Buffer);
+}
+
+#endif /* __HOST_MEMORY_ALLOCATION_LIB_H__ */
@@ -0,0 +1,40 @@
+#ifndef __HOST_UEFI_H__
+#define __HOST_UEFI_H__
+
+/*
+ * Minimal stand-in for the EDK2 <Uefi.h> so that JsmnUefiLib can be built
+ * and tested on the host.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t BOOLEAN;
+typedef int8_t INT8;
+typedef uint8_t UINT8;
+typedef int16_t INT16;
+typedef uint16_t UINT16;
+typedef int32_t INT32;
+typedef uint32_t UINT32;
+typedef int64_t INT64;
+typedef uint64_t UINT64;
+typedef intptr_t INTN;
+typedef uintptr_t UINTN;
+typedef char CHAR8;
+typedef uint16_t CHAR16;
+typedef void VOID;
+
+#define IN
+#define OUT
+#define OPTIONAL
+#define CONST const
+#define STATIC static
+#define EFIAPI
+#define MAX_UINTN ((UINTN)-1)
+#define MAX_INT32 ((INT32)0x7FFFFFFF)
+#define MAX_INT64 ((INT64)0x7FFFFFFFFFFFFFFFULL)
+#define MAX_UINT64 ((UINT64)0xFFFFFFFFFFFFFFFFULL)
+#define TRUE ((BOOLEAN)1)
+#define FALSE ((BOOLEAN)0)
+
+#endif /* __HOST_UEFI_H__ */